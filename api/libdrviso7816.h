@@ -24,6 +24,106 @@ typedef enum {
     DRV7816_MAP_VOLUNTARY
 } drv7816_map_mode_t;
 
+/* Communication error recovery levels, from the cheapest to the heaviest */
+typedef enum {
+    /* Clear the ISR/ring buffer state and the pending USART error flags */
+    DRV7816_RECOVER_LIGHT,
+    /* Same as light, and reprogram the current baudrate, guard time and parity */
+    DRV7816_RECOVER_RECONF,
+    /* Full USART disable/enable and driver state reinitialization */
+    DRV7816_RECOVER_FULL
+} drv7816_recover_level_t;
+
+/* Stop bits for the transactional USART reconfiguration */
+typedef enum {
+    DRV7816_STOP_1BIT,
+    DRV7816_STOP_1_5BITS
+} drv7816_stop_bits_t;
+
+/* Clock stop indicator X (first TA for T=15 in the ATR) */
+typedef enum {
+    DRV7816_CLOCK_STOP_UNSUPPORTED = 0,
+    DRV7816_CLOCK_STOP_LOW         = 1,
+    DRV7816_CLOCK_STOP_HIGH        = 2,
+    DRV7816_CLOCK_STOP_ANY         = 3
+} drv7816_clock_stop_t;
+
+/* Negotiated communication parameters of a card */
+typedef struct {
+    uint16_t fi;           /* Clock rate conversion integer (e.g. 372) */
+    uint8_t  di;           /* Baud rate adjustment integer (e.g. 1) */
+    uint8_t  guard_time;   /* Guard time programmed in the USART, in ETU */
+    uint8_t  inverse_conv; /* 1 for the inverse convention, 0 for the direct one */
+    uint8_t  ifsc;         /* Information field size of the card (T=1) */
+    uint32_t frequency;    /* Clock frequency in Hz */
+} drv7816_card_params_t;
+
+/* Direction of the data of a T=0 exchange */
+typedef enum {
+    DRV7816_EXCHANGE_OUT, /* Command data sent to the card (P3 bytes, possibly none) */
+    DRV7816_EXCHANGE_IN   /* Response data received from the card (P3 = 0 means 256) */
+} drv7816_exchange_dir_t;
+
+/* T=0 TPDU, as exchanged by the optional T=0 engine of the driver */
+typedef struct {
+    uint8_t        header[5];     /* CLA, INS, P1, P2, P3 */
+    drv7816_exchange_dir_t dir;   /* Outgoing (command data, possibly none) or incoming */
+    const uint8_t *data_in;       /* Command data (P3 bytes) of an outgoing TPDU */
+    uint8_t       *data_out;      /* Response data buffer of an incoming TPDU */
+    uint32_t       data_out_size; /* Size of the response data buffer */
+    uint32_t       data_out_len;  /* Received response data length */
+    uint8_t        sw1;
+    uint8_t        sw2;
+} drv7816_t0_tpdu_t;
+
+/* Driver statistics */
+typedef struct {
+    uint32_t rx_bytes;           /* Bytes stored in the reception ring buffer */
+    uint32_t tx_bytes;           /* Bytes pushed on the line (including resends) */
+    uint32_t rx_echo_drops;      /* Echoes of our own bytes dropped (expected) */
+    uint32_t rx_lock_drops;      /* Bytes lost because the ring buffer was locked */
+    uint32_t rx_full_drops;      /* Bytes lost because the ring buffer was full */
+    uint32_t rx_ring_high_water; /* Maximum ring buffer occupancy */
+    uint32_t rx_overruns;        /* Overrun errors */
+    uint32_t rx_noise_errors;    /* Noise errors */
+    uint32_t rx_parity_errors;   /* Card bytes NACKed on a parity error (then repeated) */
+    uint32_t tx_retransmits;     /* Bytes resent after a parity/framing error */
+    uint32_t speed_step_downs;   /* Adaptive speed fallbacks */
+    uint32_t speed_step_ups;     /* Adaptive speed probes back up */
+} drv7816_stats_t;
+
+/* Status of a non-blocking T=0 exchange */
+typedef enum {
+    DRV7816_EXCHANGE_BUSY,
+    DRV7816_EXCHANGE_DONE,
+    DRV7816_EXCHANGE_ERROR
+} drv7816_exchange_status_t;
+
+/* Non-blocking T=0 exchange object, holding its own buffers and deadlines.
+ * The fields are private to the driver, except for status, data, data_len,
+ * sw1 and sw2 which can be read once the exchange is over.
+ */
+typedef struct {
+    drv7816_exchange_status_t status;
+    uint8_t  header[5];
+    uint8_t  data[256];   /* Command data (outgoing) or response data (incoming) */
+    uint32_t data_len;    /* Received response data length */
+    uint8_t  sw1;
+    uint8_t  sw2;
+    /* Private */
+    uint8_t  state;
+    uint8_t  outgoing;
+    uint8_t  resent;
+    uint8_t  hdr_offset;
+    uint32_t len;
+    uint32_t offset;
+    uint32_t ack_end;
+    uint32_t resp_max;
+    uint32_t wt_us;
+    uint32_t wt_frequency; /* Clock frequency wt_us was computed for */
+    uint64_t start_tick;
+} drv7816_exchange_t;
+
 /* The SMARTCARD_CONTACT pin is at state high (pullup to Vcc) when no card is
  * not present, and at state low (linked to GND) when the card is inserted.
  */
@@ -69,6 +169,93 @@ int platform_smartcard_init(void);
   */
 int platform_SC_adapt_clocks(uint32_t *etu, uint32_t *frequency);
 
+/* Current clock frequency in Hz (0 when not configured yet). With the adaptive
+ * speed fallback, it may change under the upper layer.
+ */
+/*@
+  @ assigns \nothing;
+  */
+uint32_t platform_SC_get_frequency(void);
+
+/*
+ * Transactional USART reconfiguration: changes are staged between begin and
+ * commit, and pushed in one single USART reprogramming (none if nothing changed).
+ */
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_config_begin(void);
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_config_set_convention(uint8_t inverse);
+
+/*@
+  @ requires \valid(etu);
+  @ requires \valid(frequency);
+  @ requires \separated(etu,frequency);
+  @ assigns *frequency;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_config_set_clocks(uint32_t *etu, uint32_t *frequency, uint8_t guard_time);
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_config_set_stop_bits(drv7816_stop_bits_t stop_bits);
+
+/*@
+  @ assigns \nothing;
+  */
+void platform_SC_config_abort(void);
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_config_commit(void);
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_apply_params(const drv7816_card_params_t *params);
+
+/* Cache of proven-good parameters, keyed by the ATR of the card */
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_params_cache_store(const uint8_t *atr, uint32_t atr_len, const drv7816_card_params_t *params);
+
+/*@
+  @ assigns *params;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_params_cache_lookup(const uint8_t *atr, uint32_t atr_len, drv7816_card_params_t *params);
+
+/*@
+  @ assigns \nothing;
+  */
+void platform_SC_params_cache_report_error(const uint8_t *atr, uint32_t atr_len);
+
+/*@
+  @ assigns \nothing;
+  */
+void platform_SC_params_cache_report_success(const uint8_t *atr, uint32_t atr_len);
+
+/*@
+  @ assigns *params;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_fast_resume(const uint8_t *atr, uint32_t atr_len, uint8_t specific_mode, drv7816_card_params_t *params);
+
 /*
  * Low level related functions: we handle the low level USAT/smartcard
  * bytes send and receive stuff here.
@@ -87,6 +274,30 @@ int platform_SC_set_direct_conv(void);
 int platform_SC_set_inverse_conv(void);
 
 
+/* Clock stop power saving mode */
+
+/*@
+  @ assigns \nothing;
+  */
+void platform_SC_set_clock_stop_indicator(uint8_t ta_t15);
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_clock_stop(void);
+
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_clock_resume(void);
+
+/*@
+  @ assigns \nothing;
+  */
+uint64_t platform_SC_get_clock_stopped_time(void);
+
 /* Smartcard putc and getc handling errors, with timeout in milliseconds */
 
 /*@
@@ -116,6 +327,14 @@ int platform_SC_putc(uint8_t c, uint32_t timeout, uint8_t reset);
   */
 uint64_t platform_get_microseconds_ticks(void);
 
+#if CONFIG_USR_DRV_DRVISO7816_TIM_TIMEBASE
+/* Get ticks/time in microseconds without syscall, for hot polling loops */
+/*@
+  @ assigns \nothing;
+  */
+uint64_t platform_get_fast_microseconds_ticks(void);
+#endif
+
 /*@
   @ assigns \nothing;
   */
@@ -137,6 +356,12 @@ void platform_smartcard_lost(void);
   */
 void platform_smartcard_reinit(void);
 
+/*@
+  @ assigns \nothing;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_recover(drv7816_recover_level_t level);
+
 /*@
   @ assigns \nothing;
   */
@@ -157,4 +382,47 @@ int platform_smartcard_unmap(void);
   */
 int platform_smartcard_set_1ETU_guardtime(void);
 
+#if CONFIG_USR_DRV_DRVISO7816_T0_ENGINE
+/* Exchange a whole T=0 TPDU, handling the procedure bytes, with a
+ * waiting time in microseconds between each character.
+ */
+/*@
+  @ assigns *tpdu;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_T0_exchange(drv7816_t0_tpdu_t *tpdu, uint32_t wt_us);
+
+/* Non-blocking flavor: start the exchange, then step it until it is over.
+ * data holds the P3 command bytes of an outgoing exchange (NULL for an incoming
+ * one), and resp_max is the maximum response length accepted by an incoming one.
+ */
+/*@
+  @ assigns *exchange;
+  @ ensures \result == 0 || \result == -1;
+  */
+int platform_SC_exchange_start(drv7816_exchange_t *exchange, const uint8_t header[5], const uint8_t *data,
+                               drv7816_exchange_dir_t dir, uint32_t resp_max, uint32_t wt_us);
+
+/*@
+  @ assigns *exchange;
+  */
+drv7816_exchange_status_t platform_SC_exchange_step(drv7816_exchange_t *exchange);
+#endif
+
+/*@
+  @ assigns *stats;
+  */
+void platform_SC_get_stats(drv7816_stats_t *stats);
+
+/*@
+  @ assigns \nothing;
+  */
+void platform_SC_reset_stats(void);
+
+/* Output the pending deferred debug logs (if any) */
+/*@
+  @ assigns \nothing;
+  */
+void smartcard_log_drain(void);
+
 #endif /* __SMARTCARD_ISO7816_PLATFORM_H__ */
@@ -0,0 +1,170 @@
+/***************************
+* Cache of the proven-good negotiated parameters of the
+* cards, keyed by a hash of their ATR.
+*
+*/
+#include "libc/types.h"
+#include "libc/string.h"
+#include "libdrviso7816.h"
+
+/* Our fleet only uses a handful of card models: keep the cache small */
+#define SC_PARAMS_CACHE_SIZE       4
+/* Number of consecutive errors reported on an entry before evicting it */
+#define SC_PARAMS_CACHE_MAX_ERRORS 3
+/* Maximum ATR length (TS + 32 characters) */
+#define SC_ATR_MAX_LEN             33
+
+typedef struct {
+	uint8_t  valid;
+	uint8_t  errors;
+	uint8_t  atr_len;
+	uint8_t  atr[SC_ATR_MAX_LEN];
+	uint32_t hash;
+	uint32_t stamp; /* For the LRU eviction */
+	drv7816_card_params_t params;
+} sc_params_cache_entry_t;
+
+static sc_params_cache_entry_t sc_params_cache[SC_PARAMS_CACHE_SIZE];
+static uint32_t sc_params_cache_stamp = 0;
+
+/* FNV-1a hash of the ATR */
+static uint32_t platform_SC_atr_hash(const uint8_t *atr, uint32_t atr_len){
+	uint32_t hash = 0x811c9dc5;
+	uint32_t i;
+
+	for(i = 0; i < atr_len; i++){
+		hash ^= atr[i];
+		hash *= 0x01000193;
+	}
+	return hash;
+}
+
+static sc_params_cache_entry_t *platform_SC_params_cache_find(const uint8_t *atr, uint32_t atr_len){
+	uint32_t hash;
+	unsigned int i;
+
+	if((atr == NULL) || (atr_len == 0) || (atr_len > SC_ATR_MAX_LEN)){
+		return NULL;
+	}
+	hash = platform_SC_atr_hash(atr, atr_len);
+	for(i = 0; i < SC_PARAMS_CACHE_SIZE; i++){
+		if(sc_params_cache[i].valid && (sc_params_cache[i].hash == hash)){
+			/* Check the whole ATR to rule out hash collisions */
+			if((sc_params_cache[i].atr_len == atr_len) && (memcmp(sc_params_cache[i].atr, atr, atr_len) == 0)){
+				return &sc_params_cache[i];
+			}
+		}
+	}
+	return NULL;
+}
+
+int platform_SC_params_cache_store(const uint8_t *atr, uint32_t atr_len, const drv7816_card_params_t *params){
+	sc_params_cache_entry_t *entry;
+	unsigned int i;
+
+	if((atr == NULL) || (atr_len == 0) || (atr_len > SC_ATR_MAX_LEN) || (params == NULL)){
+		goto err;
+	}
+	entry = platform_SC_params_cache_find(atr, atr_len);
+	if(entry == NULL){
+		/* Take a free entry, or evict the least recently used one */
+		entry = &sc_params_cache[0];
+		for(i = 0; i < SC_PARAMS_CACHE_SIZE; i++){
+			if(!sc_params_cache[i].valid){
+				entry = &sc_params_cache[i];
+				break;
+			}
+			if(sc_params_cache[i].stamp < entry->stamp){
+				entry = &sc_params_cache[i];
+			}
+		}
+		entry->hash = platform_SC_atr_hash(atr, atr_len);
+		memcpy(entry->atr, atr, atr_len);
+		entry->atr_len = atr_len;
+	}
+	memcpy(&(entry->params), params, sizeof(drv7816_card_params_t));
+	entry->errors = 0;
+	entry->stamp = ++sc_params_cache_stamp;
+	entry->valid = 1;
+
+	return 0;
+err:
+	return -1;
+}
+
+int platform_SC_params_cache_lookup(const uint8_t *atr, uint32_t atr_len, drv7816_card_params_t *params){
+	sc_params_cache_entry_t *entry;
+
+	if(params == NULL){
+		goto err;
+	}
+	entry = platform_SC_params_cache_find(atr, atr_len);
+	if(entry == NULL){
+		goto err;
+	}
+	memcpy(params, &(entry->params), sizeof(drv7816_card_params_t));
+	entry->stamp = ++sc_params_cache_stamp;
+
+	return 0;
+err:
+	return -1;
+}
+
+/* Repeated errors with cached parameters evict the entry, so that the next
+ * insertion falls back to the full ATR parsing and negotiation.
+ */
+void platform_SC_params_cache_report_error(const uint8_t *atr, uint32_t atr_len){
+	sc_params_cache_entry_t *entry = platform_SC_params_cache_find(atr, atr_len);
+
+	if(entry == NULL){
+		return;
+	}
+	entry->errors++;
+	if(entry->errors >= SC_PARAMS_CACHE_MAX_ERRORS){
+		memset(entry, 0, sizeof(sc_params_cache_entry_t));
+	}
+	return;
+}
+
+void platform_SC_params_cache_report_success(const uint8_t *atr, uint32_t atr_len){
+	sc_params_cache_entry_t *entry = platform_SC_params_cache_find(atr, atr_len);
+
+	if(entry == NULL){
+		return;
+	}
+	entry->errors = 0;
+	return;
+}
+
+/* Fast resume: if the card is known, return its cached parameters so that the
+ * upper layer skips the conservative negotiation.
+ * The PPS exchange must be performed at the default Fd/Dd: when the card is in
+ * negotiable mode, the parameters are only returned, and the upper layer applies
+ * them with platform_SC_apply_params() once the card has answered the PPS request.
+ * When the card is in specific mode (TA2 present), it already uses these parameters
+ * and they are directly applied.
+ * Returns -1 on a cache miss (or when the parameters cannot be applied), in which
+ * case the regular path must be used.
+ */
+int platform_SC_fast_resume(const uint8_t *atr, uint32_t atr_len, uint8_t specific_mode, drv7816_card_params_t *params){
+	sc_params_cache_entry_t *entry;
+
+	if(params == NULL){
+		goto err;
+	}
+	entry = platform_SC_params_cache_find(atr, atr_len);
+	if(entry == NULL){
+		goto err;
+	}
+	if(specific_mode && platform_SC_apply_params(&(entry->params))){
+		/* These parameters are not usable anymore, drop them */
+		memset(entry, 0, sizeof(sc_params_cache_entry_t));
+		goto err;
+	}
+	memcpy(params, &(entry->params), sizeof(drv7816_card_params_t));
+	entry->stamp = ++sc_params_cache_stamp;
+
+	return 0;
+err:
+	return -1;
+}
@@ -0,0 +1,91 @@
+/***************************
+* Deferred (non-blocking) debug logging for the ISO7816
+* driver: log_printf() call sites only push a format ID and
+* raw arguments in a lock-free ring, formatted later.
+*
+*/
+#include "libc/types.h"
+#include "libc/stdio.h"
+#include "libdrviso7816.h"
+
+#if SMARTCARD_DEBUG && CONFIG_USR_DRV_DRVISO7816_DEFERRED_LOG
+
+/* Must be a power of 2 */
+#define SMARTCARD_LOG_RING_SIZE 64
+
+typedef struct {
+	/* Index + 1 of the entry once it is fully written */
+	volatile uint32_t seq;
+	/* The format address is the format ID (a host-side decoder resolves it
+	 * from the .rodata section of the ELF file)
+	 */
+	const char *fmt;
+	uint32_t args[4];
+} smartcard_log_entry_t;
+
+/* These are global (and not static) so that a host-side decoder can read
+ * them through the debugger
+ */
+smartcard_log_entry_t smartcard_log_ring[SMARTCARD_LOG_RING_SIZE];
+volatile uint32_t smartcard_log_head = 0;
+volatile uint32_t smartcard_log_tail = 0;
+volatile uint32_t smartcard_log_dropped = 0;
+
+/* Push a log entry: this is lock-free (and ISR safe), and drops the entry
+ * when the ring is full.
+ */
+void smartcard_log_push(const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+	smartcard_log_entry_t *entry;
+	uint32_t head = __atomic_load_n(&smartcard_log_head, __ATOMIC_RELAXED);
+
+	/* Reserve our slot */
+	do {
+		if((head - __atomic_load_n(&smartcard_log_tail, __ATOMIC_ACQUIRE)) >= SMARTCARD_LOG_RING_SIZE){
+			__atomic_fetch_add(&smartcard_log_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+	} while(!__atomic_compare_exchange_n(&smartcard_log_head, &head, head + 1, true,
+	                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	entry = &smartcard_log_ring[head & (SMARTCARD_LOG_RING_SIZE - 1)];
+	entry->fmt = fmt;
+	entry->args[0] = a0;
+	entry->args[1] = a1;
+	entry->args[2] = a2;
+	entry->args[3] = a3;
+	/* Publish the entry */
+	__atomic_store_n(&entry->seq, head + 1, __ATOMIC_RELEASE);
+	return;
+}
+
+#endif
+
+/* Format and output the pending log entries. This is to be called by
+ * the upper layer out of the timing critical paths (e.g. in its idle loop).
+ */
+void smartcard_log_drain(void)
+{
+#if SMARTCARD_DEBUG && CONFIG_USR_DRV_DRVISO7816_DEFERRED_LOG
+	smartcard_log_entry_t *entry;
+	uint32_t tail = smartcard_log_tail;
+	uint32_t dropped;
+
+	while(tail != __atomic_load_n(&smartcard_log_head, __ATOMIC_ACQUIRE)){
+		entry = &smartcard_log_ring[tail & (SMARTCARD_LOG_RING_SIZE - 1)];
+		if(__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != (tail + 1)){
+			/* This entry is still being written, get back later */
+			break;
+		}
+		printf(entry->fmt, entry->args[0], entry->args[1], entry->args[2], entry->args[3]);
+		tail++;
+		/* Release the slot */
+		__atomic_store_n(&smartcard_log_tail, tail, __ATOMIC_RELEASE);
+	}
+	dropped = __atomic_exchange_n(&smartcard_log_dropped, 0, __ATOMIC_RELAXED);
+	if(dropped != 0){
+		printf("[smartcard: %d log entries dropped]\n", dropped);
+	}
+#endif
+	return;
+}
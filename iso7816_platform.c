@@ -8,6 +8,7 @@
 #include "generated/led0.h"
 #include "generated/dfu_button.h"
 #include "libc/sanhandlers.h"
+#include "iso7816_timebase.h"
 
 
 /* The target clock frequency is 3.5MHz for the ATR < max 5MHz.
@@ -95,10 +96,40 @@ static usart_config_t smartcard_usart_config = {
         .callback_usart_putc_ptr = &platform_SC_usart_putc,
 };
 
+/* Clock stop state (see platform_SC_clock_stop) */
+static volatile bool platform_SC_clock_stopped = false;
+static uint64_t platform_SC_clock_stop_tick = 0;
+static uint64_t platform_SC_clock_stopped_us = 0;
+static void platform_SC_clock_force_restart(bool reprogram);
+
+/* Has a byte been sent to the card since its last reset? Before that, we are
+ * receiving the ATR (see platform_smartcard_irq).
+ */
+static volatile bool platform_SC_sent_since_reset = false;
+
 
 device_t dev;   /* Device configuration */
 int      dev_desc = 0;  /* Descriptor transmitted by the kernel */
 
+#if CONFIG_USR_DRV_DRVISO7816_DIRECT_GPIO
+/* Direct access to the GPIO banks holding our RST, VCC, contact and LED pins: only
+ * these banks (0x400 each) are mapped in the task, in order to set and read our pins
+ * with single BSRR/IDR accesses instead of sys_cfg syscalls.
+ */
+#define SC_GPIO_BANKS_BASE      0x40020000
+#define SC_GPIO_BANK_SIZE       0x400
+#define SC_GPIO_MAX_BANKS       9  /* A to I */
+#define SC_GPIO_IDR_OFFSET      0x10
+#define SC_GPIO_BSRR_OFFSET     0x18
+/* RST, VCC, contact and LED: at most 4 distinct banks */
+#define SC_GPIO_MAX_BANK_DEVS   4
+
+device_t gpio_bank_devs[SC_GPIO_MAX_BANK_DEVS];   /* Devices configuration */
+int      gpio_bank_devs_desc[SC_GPIO_MAX_BANK_DEVS];  /* Descriptors transmitted by the kernel */
+/* Mask of the mapped GPIO banks, we fall back to the syscalls for the other ones */
+static volatile uint16_t platform_SC_gpio_banks_mapped = 0;
+#endif
+
 static uint8_t exti_butt_count = 0;
 
 void exti_button_handler(uint8_t irq __attribute__((unused)),
@@ -140,11 +171,69 @@ void exti_handler(uint8_t irq __attribute__((unused)),
 	return;
 }
 
+#if CONFIG_USR_DRV_DRVISO7816_DIRECT_GPIO
+static void platform_SC_gpio_map_banks(void)
+{
+  uint8_t i, port, num = 0;
+  /* dev.gpios indexes of the contact, RST, VCC (and LED) pins */
+#if CONFIG_WOOKEY
+  uint8_t const pins = 4;
+#else
+  uint8_t const pins = 3;
+#endif
+
+  platform_SC_gpio_banks_mapped = 0;
+  for (i = 0; i < pins; i++) {
+      port = dev.gpios[i].kref.port;
+      if ((port >= SC_GPIO_MAX_BANKS) || (platform_SC_gpio_banks_mapped & (1 << port))) {
+          continue;
+      }
+      if (num >= SC_GPIO_MAX_BANK_DEVS) {
+          break;
+      }
+      memset((void*)&gpio_bank_devs[num], 0, sizeof(device_t));
+      strncpy(gpio_bank_devs[num].name, "smart_gpio_a", sizeof(gpio_bank_devs[num].name));
+      gpio_bank_devs[num].name[11] = 'a' + port;
+      gpio_bank_devs[num].address = SC_GPIO_BANKS_BASE + (port * SC_GPIO_BANK_SIZE);
+      gpio_bank_devs[num].size = SC_GPIO_BANK_SIZE;
+      gpio_bank_devs[num].irq_num = 0;
+      gpio_bank_devs[num].gpio_num = 0;
+      gpio_bank_devs[num].map_mode = DEV_MAP_AUTO;
+      if (sys_init(INIT_DEVACCESS, &gpio_bank_devs[num], &gpio_bank_devs_desc[num]) == SYS_E_DONE) {
+          platform_SC_gpio_banks_mapped |= (1 << port);
+      } else {
+          log_printf("Unable to map GPIO bank %c, falling back to syscalls\n", 'A' + port);
+      }
+      num++;
+  }
+  return;
+}
+
+/* Direct accesses are only allowed for the pins we have declared to the kernel
+ * (as an output for the writes), in a mapped bank: the other ones go through
+ * the syscalls, which check them.
+ */
+static inline bool platform_SC_gpio_is_direct(uint8_t kref, bool output)
+{
+  uint8_t i;
+
+  if (!(platform_SC_gpio_banks_mapped & (1 << (kref >> 4)))) {
+      return false;
+  }
+  for (i = 0; i < dev.gpio_num; i++) {
+      if ((dev.gpios[i].kref.port == (kref >> 4)) && (dev.gpios[i].kref.pin == (kref & 0xf))) {
+          return (!output || (dev.gpios[i].mode == GPIO_PIN_OUTPUT_MODE));
+      }
+  }
+  return false;
+}
+#endif
+
 uint8_t platform_early_gpio_init(void)
 {
   e_syscall_ret ret;
 
-  strncpy(dev.name, "smart_gpios", sizeof("smart_gpios"));
+  strncpy(dev.name, "smart_gpios", sizeof(dev.name));
 #if CONFIG_WOOKEY // Support for pin card led indicator
   dev.gpio_num = 5;
 #else
@@ -206,15 +295,50 @@ uint8_t platform_early_gpio_init(void)
   ret = sys_init(INIT_DEVACCESS, &dev, &dev_desc);
   if (ret != 0) {
       log_printf("Error while declaring GPIO device: %d\n", ret);
+      return ret;
   }
+
+#if CONFIG_USR_DRV_DRVISO7816_DIRECT_GPIO
+  /* Map the banks of our RST, VCC, contact and LED pins for direct access. This is
+   * optional: if the kernel refuses it, we keep on using the syscalls.
+   */
+  platform_SC_gpio_map_banks();
+#endif
   return ret;
 }
 
+/* Set and get our GPIOs (kref is (port << 4) + pin) */
+static inline e_syscall_ret platform_SC_gpio_set(uint8_t kref, uint8_t val)
+{
+#if CONFIG_USR_DRV_DRVISO7816_DIRECT_GPIO
+  uint32_t pin = kref & 0xf;
+  if (platform_SC_gpio_is_direct(kref, true)) {
+      /* Single atomic set/reset through BSRR */
+      *((volatile uint32_t*)(SC_GPIO_BANKS_BASE + ((kref >> 4) * SC_GPIO_BANK_SIZE) + SC_GPIO_BSRR_OFFSET)) =
+          val ? (1 << pin) : (1 << (pin + 16));
+      return SYS_E_DONE;
+  }
+#endif
+  return sys_cfg(CFG_GPIO_SET, kref, val);
+}
+
+static inline e_syscall_ret platform_SC_gpio_get(uint8_t kref, uint8_t *val)
+{
+#if CONFIG_USR_DRV_DRVISO7816_DIRECT_GPIO
+  uint32_t pin = kref & 0xf;
+  if (platform_SC_gpio_is_direct(kref, false)) {
+      *val = (*((volatile uint32_t*)(SC_GPIO_BANKS_BASE + ((kref >> 4) * SC_GPIO_BANK_SIZE) + SC_GPIO_IDR_OFFSET)) >> pin) & 0x1;
+      return SYS_E_DONE;
+  }
+#endif
+  return sys_cfg(CFG_GPIO_GET, kref, val);
+}
+
 
 static inline void toggle_smartcard_led_on(void){
 #if CONFIG_WOOKEY
 	/* toogle led on */
-	sys_cfg(CFG_GPIO_SET, (uint8_t)((led0_dev_infos.gpios[LED0].port << 4) + led0_dev_infos.gpios[LED0].pin), 1);
+	platform_SC_gpio_set((uint8_t)((led0_dev_infos.gpios[LED0].port << 4) + led0_dev_infos.gpios[LED0].pin), 1);
 #endif
 	return;
 }
@@ -222,20 +346,20 @@ static inline void toggle_smartcard_led_on(void){
 static inline void toggle_smartcard_led_off(void){
 #if CONFIG_WOOKEY
 	/* toogle led off */
-	sys_cfg(CFG_GPIO_SET, (uint8_t)((led0_dev_infos.gpios[LED0].port << 4) + led0_dev_infos.gpios[LED0].pin), 0);
+	platform_SC_gpio_set((uint8_t)((led0_dev_infos.gpios[LED0].port << 4) + led0_dev_infos.gpios[LED0].pin), 0);
 #endif
 	return;
 }
 
 static inline void toggle_smartcard_led(){
 	uint64_t end_tick;
-	uint64_t start_tick = platform_get_microseconds_ticks();
+	uint64_t start_tick = platform_SC_ticks_us();
 	/* Force LED off */
 	toggle_smartcard_led_off();
 	/* Wait a bit (100 milliseconds) */
-	end_tick = platform_get_microseconds_ticks();
+	end_tick = platform_SC_ticks_us();
 	while((end_tick - start_tick) < 100000){
-		end_tick = platform_get_microseconds_ticks();
+		end_tick = platform_SC_ticks_us();
 	}
 	/* Force LED on */
 	toggle_smartcard_led_on();
@@ -245,16 +369,19 @@ static inline void toggle_smartcard_led(){
 void platform_set_smartcard_rst(uint8_t val)
 {
   e_syscall_ret ret;
-  ret = sys_cfg(CFG_GPIO_SET, (uint8_t)(('E' - 'A')<< 4) + 3, val);
+  /* The card (re)starts with its ATR, which it cannot send without clock */
+  platform_SC_sent_since_reset = false;
+  platform_SC_clock_force_restart(true);
+  ret = platform_SC_gpio_set((uint8_t)(('E' - 'A')<< 4) + 3, val);
   if (ret != SYS_E_DONE) {
-    log_printf("unable to set gpio RST pin value %x: %x\n", val, strerror(ret));
+    log_printf("unable to set gpio RST pin value %x: %s\n", val, strerror(ret));
   }
 }
 
 void platform_set_smartcard_vcc(uint8_t val)
 {
   e_syscall_ret ret;
-  ret = sys_cfg(CFG_GPIO_SET, (uint8_t)(('D' - 'A') << 4) + 7, val);
+  ret = platform_SC_gpio_set((uint8_t)(('D' - 'A') << 4) + 7, val);
   if (ret != SYS_E_DONE) {
     log_printf("unable to set gpio VCC pin with %x: %s\n", val, strerror(ret));
   }
@@ -318,13 +445,13 @@ uint8_t platform_is_smartcard_inserted(void)
 
         if(platform_SC_gpio_smartcard_contact_changed == 1){
 
-            sys_get_systick(&count, PREC_MICRO);
+            count = platform_SC_ticks_us();
             local_count = count;
             do {
-                sys_get_systick(&local_count, PREC_MICRO);
+                local_count = platform_SC_ticks_us();
             } while (((local_count - count) / 1000) < 100);
 
-            ret = sys_cfg(CFG_GPIO_GET,
+            ret = platform_SC_gpio_get(
                   (uint8_t)((smartcard_dev_infos.gpios[SMARTCARD_CON].port << 4 )
                             + smartcard_dev_infos.gpios[SMARTCARD_CON].pin), &val);
             if (ret != SYS_E_DONE) {
@@ -333,7 +460,7 @@ uint8_t platform_is_smartcard_inserted(void)
             }
             if (!val) {
                 /* toggle led on */
-                ret = sys_cfg(CFG_GPIO_SET,
+                ret = platform_SC_gpio_set(
                   (uint8_t)((smartcard_dev_infos.gpios[LED0].port << 4 )
                            + smartcard_dev_infos.gpios[LED0].pin)
                                                  ,1);
@@ -344,7 +471,7 @@ uint8_t platform_is_smartcard_inserted(void)
 
             } else {
                 /* toggle led off */
-                ret = sys_cfg(CFG_GPIO_SET, (uint8_t)((smartcard_dev_infos.gpios[LED0].port << 4 )
+                ret = platform_SC_gpio_set((uint8_t)((smartcard_dev_infos.gpios[LED0].port << 4 )
                                                 + smartcard_dev_infos.gpios[LED0].pin),0);
                 if (ret != SYS_E_DONE) {
                   log_printf("Unable to toggle LED0, ret %s\n", strerror(ret));
@@ -363,7 +490,10 @@ uint8_t platform_is_smartcard_inserted(void)
 
 void platform_smartcard_lost(void)
 {
-    sys_cfg(CFG_GPIO_SET, (uint8_t)((('C' - 'A') << 4) + 4), 0);
+    /* The next card must get a clock for its ATR */
+    platform_SC_clock_force_restart(true);
+    platform_SC_sent_since_reset = false;
+    platform_SC_gpio_set((uint8_t)((('C' - 'A') << 4) + 4), 0);
 }
 
 /* Initialize the USART in smartcard mode as
@@ -434,6 +564,116 @@ static volatile uint8_t platform_SC_pending_send_byte = 0;
 static volatile uint8_t platform_SC_byte = 0;
 
 
+#if CONFIG_USR_DRV_DRVISO7816_TIM_TIMEBASE
+/* Syscall-free timebase: the 32-bit TIM5 general purpose timer is mapped in the
+ * task, calibrated once against the systick so that it counts microseconds, and
+ * extended to 64 bits in software. This avoids one sys_get_systick syscall per
+ * call in the hot polling loops.
+ */
+#define SC_TIM_BASE             0x40000C00
+#define SC_TIM_SIZE             0x400
+#define SC_TIM_CR1              ((volatile uint32_t*)(SC_TIM_BASE + 0x00))
+#define SC_TIM_CR1_CEN          (1 << 0)
+#define SC_TIM_EGR              ((volatile uint32_t*)(SC_TIM_BASE + 0x14))
+#define SC_TIM_EGR_UG           (1 << 0)
+#define SC_TIM_CNT              ((volatile uint32_t*)(SC_TIM_BASE + 0x24))
+#define SC_TIM_PSC              ((volatile uint32_t*)(SC_TIM_BASE + 0x28))
+#define SC_TIM_ARR              ((volatile uint32_t*)(SC_TIM_BASE + 0x2C))
+/* Calibration window, in microseconds */
+#define SC_TIM_CALIBRATION_US   2000
+
+device_t timebase_dev;   /* Device configuration */
+int      timebase_dev_desc = 0;  /* Descriptor transmitted by the kernel */
+/* Is the timer mapped, and is it calibrated? If not, we fall back to the syscall */
+static volatile bool platform_SC_timebase_mapped = false;
+static volatile bool platform_SC_timebase_ready = false;
+/* Systick value at the timer start, and software extension of the counter */
+static uint64_t platform_SC_timebase_base_us = 0;
+static uint32_t platform_SC_timebase_high = 0;
+static uint32_t platform_SC_timebase_last = 0;
+
+static void platform_early_timebase_init(void)
+{
+  memset((void*)&timebase_dev, 0, sizeof(device_t));
+  strncpy(timebase_dev.name, "smart_tim5", sizeof(timebase_dev.name));
+  timebase_dev.address = SC_TIM_BASE;
+  timebase_dev.size = SC_TIM_SIZE;
+  timebase_dev.irq_num = 0;
+  timebase_dev.gpio_num = 0;
+  timebase_dev.map_mode = DEV_MAP_AUTO;
+  if (sys_init(INIT_DEVACCESS, &timebase_dev, &timebase_dev_desc) == SYS_E_DONE) {
+      platform_SC_timebase_mapped = true;
+  } else {
+      log_printf("Unable to map TIM5, falling back to the systick syscall\n");
+      platform_SC_timebase_mapped = false;
+  }
+  return;
+}
+
+/* Calibrate the timer against the systick (the timer clock is assumed to be a
+ * whole number of MHz, which is the case of the APB1 timers clocks), and make it
+ * count microseconds.
+ */
+static void platform_timebase_init(void)
+{
+  uint64_t start_tick, curr_tick;
+  uint32_t start_cnt, curr_cnt, ticks_per_us;
+
+  platform_SC_timebase_ready = false;
+  if (!platform_SC_timebase_mapped) {
+      return;
+  }
+  /* Free running at the timer clock */
+  *SC_TIM_CR1 = 0;
+  *SC_TIM_PSC = 0;
+  *SC_TIM_ARR = 0xffffffff;
+  *SC_TIM_EGR = SC_TIM_EGR_UG;
+  *SC_TIM_CR1 = SC_TIM_CR1_CEN;
+
+  sys_get_systick(&start_tick, PREC_MICRO);
+  start_cnt = *SC_TIM_CNT;
+  do {
+      sys_get_systick(&curr_tick, PREC_MICRO);
+  } while ((curr_tick - start_tick) < SC_TIM_CALIBRATION_US);
+  curr_cnt = *SC_TIM_CNT;
+  ticks_per_us = (uint32_t)(((curr_cnt - start_cnt) + ((curr_tick - start_tick) / 2)) / (curr_tick - start_tick));
+  if (ticks_per_us == 0) {
+      log_printf("TIM5 calibration failed, falling back to the systick syscall\n");
+      *SC_TIM_CR1 = 0;
+      return;
+  }
+  /* Now count microseconds (the prescaler is loaded by the update event) */
+  *SC_TIM_CR1 = 0;
+  *SC_TIM_PSC = ticks_per_us - 1;
+  *SC_TIM_EGR = SC_TIM_EGR_UG;
+  *SC_TIM_CNT = 0;
+  platform_SC_timebase_high = platform_SC_timebase_last = 0;
+  sys_get_systick(&platform_SC_timebase_base_us, PREC_MICRO);
+  *SC_TIM_CR1 = SC_TIM_CR1_CEN;
+  platform_SC_timebase_ready = true;
+  return;
+}
+
+/* Get ticks/time in microseconds without syscall (hot loops). The 32-bit counter
+ * is extended on each call: it must be called at least once every 2^32 us (about
+ * 71 minutes), and only from the main thread (not from an ISR).
+ */
+uint64_t platform_get_fast_microseconds_ticks(void){
+	uint32_t cnt;
+
+	if(!platform_SC_timebase_ready){
+		return platform_get_microseconds_ticks();
+	}
+	cnt = *SC_TIM_CNT;
+	if(cnt < platform_SC_timebase_last){
+		/* The counter has wrapped */
+		platform_SC_timebase_high++;
+	}
+	platform_SC_timebase_last = cnt;
+	return platform_SC_timebase_base_us + ((((uint64_t)platform_SC_timebase_high) << 32) | cnt);
+}
+#endif
+
 int platform_smartcard_early_init(drv7816_map_mode_t map_mode)
 {
   // TODO check the return values
@@ -446,6 +686,10 @@ int platform_smartcard_early_init(drv7816_map_mode_t map_mode)
 	if ((ret = platform_early_usart_init(map_mode)) != SYS_E_DONE) {
         	goto usart_err;
 	}
+#if CONFIG_USR_DRV_DRVISO7816_TIM_TIMEBASE
+	/* Optional: we fall back to the systick syscall if this fails */
+	platform_early_timebase_init();
+#endif
 	return 0;
 gpio_err:
 	return 1;
@@ -458,14 +702,24 @@ int platform_smartcard_init(void){
 	platform_SC_pending_receive_byte = 0;
 	platform_SC_pending_send_byte = 0;
 	platform_SC_byte = 0;
+	platform_SC_sent_since_reset = false;
+	/* Never leave a (new) card without clock: it is programmed by the init below */
+	platform_SC_clock_force_restart(false);
 
 	/* Initialize the USART in smartcard mode */
 	log_printf("==> Enable USART%d in smartcard mode!\n", smartcard_usart_config.usart);
  	usart_init(&smartcard_usart_config);
+#if CONFIG_USR_DRV_DRVISO7816_TIM_TIMEBASE
+	/* Calibrate our syscall-free timebase */
+	if(!platform_SC_timebase_ready){
+		platform_timebase_init();
+	}
+#endif
 	return 0;
 }
 
 void platform_smartcard_reinit(void){
+	platform_SC_clock_force_restart(true);
 	usart_disable(&smartcard_usart_config);
 	usart_enable(&smartcard_usart_config);
 	log_printf("==> Reinit USART%d\n", smartcard_usart_config.usart);
@@ -473,20 +727,182 @@ void platform_smartcard_reinit(void){
 	return;
 }
 
-/* Adapt clocks and guard time depending on what has been received */
-int platform_SC_adapt_clocks(uint32_t *etu, uint32_t *frequency){
+/* Transactional USART reconfiguration: the parity, baudrate, guard time/prescaler
+ * and stop bits changes are staged in a shadow configuration between
+ * platform_SC_config_begin and platform_SC_config_commit, and pushed to the USART
+ * in one single reprogramming (or none at all when nothing has changed).
+ */
+static usart_config_t smartcard_usart_pending_config;
+static volatile bool platform_SC_config_in_transaction = false;
+/* The current (and staged) smartcard CLK frequency (0 if unknown), ETU and guard time */
+static volatile uint32_t platform_SC_frequency = 0;
+static uint32_t platform_SC_pending_frequency = 0;
+static uint32_t platform_SC_etu = 0;
+static uint32_t platform_SC_pending_etu = 0;
+static uint8_t platform_SC_guard_time = 0;
+static uint8_t platform_SC_pending_guard_time = 0;
+#if CONFIG_USR_DRV_DRVISO7816_ADAPTIVE_SPEED
+/* The negotiated (i.e. maximum) frequency for the adaptive speed fallback */
+static uint32_t platform_SC_max_frequency = 0;
+#endif
+
+int platform_SC_config_begin(void){
+	if(platform_SC_config_in_transaction){
+		/* Nested transactions are not supported: do not clobber the open one */
+		return -1;
+	}
+	memcpy(&smartcard_usart_pending_config, &smartcard_usart_config, sizeof(usart_config_t));
+	platform_SC_pending_frequency = platform_SC_frequency;
+	platform_SC_pending_etu = platform_SC_etu;
+	platform_SC_pending_guard_time = platform_SC_guard_time;
+	platform_SC_config_in_transaction = true;
+	return 0;
+}
+
+int platform_SC_config_set_convention(uint8_t inverse){
+	if(!platform_SC_config_in_transaction){
+		goto err;
+	}
+	if(inverse){
+		smartcard_usart_pending_config.parity = USART_CR1_PCE_EN | USART_CR1_PS_ODD;
+	}
+	else{
+		smartcard_usart_pending_config.parity = USART_CR1_PCE_EN | USART_CR1_PS_EVEN;
+	}
+	return 0;
+err:
+	return -1;
+}
+
+int platform_SC_config_set_clocks(uint32_t *etu, uint32_t *frequency, uint8_t guard_time){
+	if(!platform_SC_config_in_transaction){
+		goto err;
+	}
+	if((etu == NULL) || (frequency == NULL)){
+		goto err;
+	}
+	/* Adapt the clocks configuration in our shadow structure */
+	if(platform_smartcard_clocks_init(&smartcard_usart_pending_config, frequency, guard_time, etu)){
+		goto err;
+	}
+	platform_SC_pending_frequency = *frequency;
+	platform_SC_pending_etu = *etu;
+	platform_SC_pending_guard_time = guard_time;
+	return 0;
+err:
+	return -1;
+}
+
+int platform_SC_config_set_stop_bits(drv7816_stop_bits_t stop_bits){
+	if(!platform_SC_config_in_transaction){
+		goto err;
+	}
+	switch(stop_bits){
+		case DRV7816_STOP_1BIT:
+			smartcard_usart_pending_config.stop_bits = USART_CR2_STOP_1BIT;
+			break;
+		case DRV7816_STOP_1_5BITS:
+			smartcard_usart_pending_config.stop_bits = USART_CR2_STOP_1_5BITS;
+			break;
+		default:
+			goto err;
+	}
+	return 0;
+err:
+	return -1;
+}
+
+/* Enable or disable the CLK output (the clock is stopped in the low state) */
+static int platform_SC_config_set_clock_output(bool enable){
+	if(!platform_SC_config_in_transaction){
+		goto err;
+	}
+	if(enable){
+		smartcard_usart_pending_config.options_cr2 |= USART_CR2_CLKEN_PIN_EN;
+	}
+	else{
+		smartcard_usart_pending_config.options_cr2 &= ~USART_CR2_CLKEN_PIN_EN;
+	}
+	return 0;
+err:
+	return -1;
+}
+
+/* Unconditionally restore the clock output (init, reinit, recovery and card lost
+ * paths). This bypasses the transactional API so that it works whatever its state,
+ * and the clock is also restored in an open transaction so that its commit does not
+ * stop it again.
+ */
+static void platform_SC_clock_force_restart(bool reprogram){
 	uint32_t old_mask;
 	usart_config_t *config = &smartcard_usart_config;
 
-	if(config->mode != SMARTCARD){
+	if(platform_SC_clock_stopped){
+		platform_SC_clock_stopped_us += platform_SC_ticks_us() - platform_SC_clock_stop_tick;
+		platform_SC_clock_stopped = false;
+	}
+	smartcard_usart_pending_config.options_cr2 |= USART_CR2_CLKEN_PIN_EN;
+	if(config->options_cr2 & USART_CR2_CLKEN_PIN_EN){
+		return;
+	}
+	config->options_cr2 |= USART_CR2_CLKEN_PIN_EN;
+	if(reprogram){
+		old_mask = config->set_mask;
+		config->set_mask = USART_SET_OPTIONS_CR2;
+		usart_init(&smartcard_usart_config);
+		config->set_mask = old_mask;
+	}
+	return;
+}
+
+void platform_SC_config_abort(void){
+	platform_SC_config_in_transaction = false;
+	return;
+}
+
+int platform_SC_config_commit(void){
+	uint32_t old_mask;
+	uint32_t mask = 0;
+	usart_config_t *config = &smartcard_usart_config;
+	usart_config_t *pending = &smartcard_usart_pending_config;
+
+	if(!platform_SC_config_in_transaction){
 		goto err;
 	}
-	old_mask = config->set_mask;
-	/* Adapt the clocks configuration in our structure */
-	if(platform_smartcard_clocks_init(config, frequency, 1, etu)){
+	platform_SC_config_in_transaction = false;
+	if(config->mode != SMARTCARD){
 		goto err;
 	}
-	config->set_mask = USART_SET_BAUDRATE | USART_SET_GUARD_TIME_PS;
+	/* Only reprogram what has actually changed */
+	if(pending->baudrate != config->baudrate){
+		config->baudrate = pending->baudrate;
+		mask |= USART_SET_BAUDRATE;
+	}
+	if(pending->guard_time_prescaler != config->guard_time_prescaler){
+		config->guard_time_prescaler = pending->guard_time_prescaler;
+		mask |= USART_SET_GUARD_TIME_PS;
+	}
+	if(pending->parity != config->parity){
+		config->parity = pending->parity;
+		mask |= USART_SET_PARITY;
+	}
+	if(pending->stop_bits != config->stop_bits){
+		config->stop_bits = pending->stop_bits;
+		mask |= USART_SET_STOP_BITS;
+	}
+	if(pending->options_cr2 != config->options_cr2){
+		config->options_cr2 = pending->options_cr2;
+		mask |= USART_SET_OPTIONS_CR2;
+	}
+	platform_SC_frequency = platform_SC_pending_frequency;
+	platform_SC_etu = platform_SC_pending_etu;
+	platform_SC_guard_time = platform_SC_pending_guard_time;
+	if(mask == 0){
+		/* Nothing to do, do not disturb the line */
+		return 0;
+	}
+	old_mask = config->set_mask;
+	config->set_mask = mask;
 	/* Adapt the configuration at the USART level */
 	usart_init(&smartcard_usart_config);
 	config->set_mask = old_mask;
@@ -496,6 +912,72 @@ err:
 	return -1;
 }
 
+/* Adapt clocks and guard time depending on what has been received */
+int platform_SC_adapt_clocks(uint32_t *etu, uint32_t *frequency){
+	if(platform_SC_config_begin()){
+		goto err;
+	}
+	if(platform_SC_config_set_clocks(etu, frequency, 1)){
+		goto err_abort;
+	}
+	if(platform_SC_config_commit()){
+		goto err;
+	}
+#if CONFIG_USR_DRV_DRVISO7816_ADAPTIVE_SPEED
+	/* This is our new reference speed */
+	platform_SC_max_frequency = *frequency;
+#endif
+	return 0;
+err_abort:
+	platform_SC_config_abort();
+err:
+	return -1;
+}
+
+/* Current clock frequency (it may be changed by the adaptive speed fallback) */
+uint32_t platform_SC_get_frequency(void){
+	return platform_SC_frequency;
+}
+
+/* Apply a full set of (already negotiated) card parameters at once: convention,
+ * clocks and guard time. This is used to jump straight to the best settings of a
+ * known card (see the parameters cache).
+ */
+int platform_SC_apply_params(const drv7816_card_params_t *params){
+	uint32_t etu, frequency;
+
+	if(params == NULL){
+		goto err;
+	}
+	if(params->di == 0){
+		/* Avoid division by 0 */
+		goto err;
+	}
+	etu = params->fi / params->di;
+	frequency = params->frequency;
+	if(platform_SC_config_begin()){
+		goto err;
+	}
+	if(platform_SC_config_set_clocks(&etu, &frequency, params->guard_time)){
+		goto err_abort;
+	}
+	if(platform_SC_config_set_convention(params->inverse_conv)){
+		goto err_abort;
+	}
+	if(platform_SC_config_commit()){
+		goto err;
+	}
+#if CONFIG_USR_DRV_DRVISO7816_ADAPTIVE_SPEED
+	/* This is our new reference speed */
+	platform_SC_max_frequency = frequency;
+#endif
+	return 0;
+err_abort:
+	platform_SC_config_abort();
+err:
+	return -1;
+}
+
 /*
  * Low level related functions: we handle the low level USAT/smartcard
  * bytes send and receive stuff here.
@@ -513,13 +995,66 @@ static uint32_t SC_mutex;
 
 volatile unsigned int received = 0;
 
+/* Driver statistics, mainly accounting the silent byte loss paths of the ISR.
+ * NB: these are only updated by the ISR (except for the sent bytes).
+ */
+static volatile drv7816_stats_t platform_SC_stats;
+
+void platform_SC_get_stats(drv7816_stats_t *stats){
+	if(stats == NULL){
+		return;
+	}
+	memcpy(stats, (void*)&platform_SC_stats, sizeof(drv7816_stats_t));
+	return;
+}
+
+void platform_SC_reset_stats(void){
+	memset((void*)&platform_SC_stats, 0, sizeof(drv7816_stats_t));
+	return;
+}
+
 static void platform_smartcard_irq(uint32_t status __attribute__((unused)), uint32_t data){
-	/* Dummy read variable */
+	/* Dummy read variable (only written, to ACK the interrupt) */
 	uint8_t dummy_usart_read = 0;
-	/* Check if we have a parity error */
+	unsigned int occupancy;
+	(void)dummy_usart_read;
+	/* Account the overrun and noise errors (the data is still valid, these
+	 * flags are ACKed by the SR then DR reads)
+	 */
+	if (get_reg(&status, USART_SR_ORE)) {
+		platform_SC_stats.rx_overruns++;
+	}
+	if (get_reg(&status, USART_SR_NF)) {
+		platform_SC_stats.rx_noise_errors++;
+	}
+	/* A parity or framing error on a byte received from the card while we are in
+	 * receive mode (after the TC of our last byte, whether the upper layer has
+	 * acknowledged the send or not): this is not a NACK of our byte, and the card
+	 * repeats its byte after our NACK. Drop it.
+	 * NB: before any byte has been sent since the card reset, erroneous bytes are
+	 * still stored as before since the upper layer relies on this to detect the
+	 * inverse convention from TS.
+	 */
+	if ((get_reg(&status, USART_SR_PE) || get_reg(&status, USART_SR_FE)) &&
+	    ((platform_SC_pending_send_byte == 0) || (platform_SC_pending_send_byte == 2)) &&
+	    platform_SC_sent_since_reset) {
+		/* The USART NACKs the byte and the card repeats it: this is a retransmit
+		 * on our receive path (not accounted during the ATR, where the parity
+		 * errors are expected until the convention is known)
+		 */
+		if (get_reg(&status, USART_SR_PE)) {
+			platform_SC_stats.rx_parity_errors++;
+		}
+		/* Dummy read of the DR register to ACK the interrupt */
+		dummy_usart_read = data & 0xff;
+		return;
+	}
+
+	/* Check if we have a parity error (i.e. a NACK of our byte) */
 	if ((get_reg(&status, USART_SR_PE)) && (platform_SC_pending_send_byte != 0)) {
 		/* Parity error, program a resend */
 		platform_SC_pending_send_byte = 3;
+		platform_SC_stats.tx_retransmits++;
 		/* Dummy read of the DR register to ACK the interrupt */
 		dummy_usart_read = data & 0xff;
 		return;
@@ -529,6 +1064,7 @@ static void platform_smartcard_irq(uint32_t status __attribute__((unused)), uint
 	if ((get_reg(&status, USART_SR_FE)) && (platform_SC_pending_send_byte != 0)) {
 		/* Frame error, program a resend */
 		platform_SC_pending_send_byte = 4;
+		platform_SC_stats.tx_retransmits++;
 		/* Dummy read of the DR register to ACK the interrupt */
 		dummy_usart_read = data & 0xff;
 		return;
@@ -537,15 +1073,25 @@ static void platform_smartcard_irq(uint32_t status __attribute__((unused)), uint
 	/* We have sent our byte */
 	if ((get_reg(&status, USART_SR_TC)) && (platform_SC_pending_send_byte != 0)) {
 		/* Clear TC, not needed here (done in posthook) */
-		/* Signal that the byte has been sent */
+		/* Signal that the byte has been sent. From now on, we are back in
+		 * receive mode: the echo of our own byte (RXNE) is always raised before
+		 * TC (which comes after the guard time), so any byte received from now on
+		 * comes from the card, even if the upper layer has not acknowledged the
+		 * send yet through platform_SC_putc.
+		 * NB: when RXNE is raised together with TC, the data is our echo and is
+		 * dropped here.
+		 */
 		platform_SC_pending_send_byte = 2;
 		return;
 	}
 
 	/* We can actually read data */
 	if (get_reg(&status, USART_SR_RXNE)){
-		/* We are in our sending state, no need to treceive anything */
-		if(platform_SC_pending_send_byte != 0){
+		/* Our byte is still on the line (or is being resent): this is the echo
+		 * of our own transmission on the half-duplex I/O line, drop it.
+		 */
+		if((platform_SC_pending_send_byte != 0) && (platform_SC_pending_send_byte != 2)){
+			platform_SC_stats.rx_echo_drops++;
 			return;
 		}
 		/* Lock the mutex */
@@ -554,6 +1100,7 @@ static void platform_smartcard_irq(uint32_t status __attribute__((unused)), uint
 			 * This means that we will miss bytes here ... But this is better than corrupting our
 			 * reception ring buffer!
 			 */
+			platform_SC_stats.rx_lock_drops++;
 			return;
 		}
 
@@ -565,6 +1112,7 @@ static void platform_smartcard_irq(uint32_t status __attribute__((unused)), uint
 			/* Unlock the mutex */
             mutex_unlock(&SC_mutex);
             dummy_usart_read = data & 0xff;
+            platform_SC_stats.rx_full_drops++;
             return;
 		}
 		if(received_SC_bytes_end >= sizeof(received_SC_bytes)){
@@ -582,6 +1130,12 @@ static void platform_smartcard_irq(uint32_t status __attribute__((unused)), uint
 		/* Wrap up our ring buffer */
 		received_SC_bytes_end = (received_SC_bytes_end + 1) % sizeof(received_SC_bytes);
 		platform_SC_pending_receive_byte = 1;
+		platform_SC_stats.rx_bytes++;
+		/* Keep track of the ring buffer high water mark */
+		occupancy = (received_SC_bytes_end + sizeof(received_SC_bytes) - received_SC_bytes_start) % sizeof(received_SC_bytes);
+		if(occupancy > platform_SC_stats.rx_ring_high_water){
+			platform_SC_stats.rx_ring_high_water = occupancy;
+		}
 
 		/* Unlock the mutex */
 		mutex_unlock(&SC_mutex);
@@ -599,8 +1153,6 @@ int platform_SC_set_direct_conv(void){
 
 /* Set the inverse convention at low level */
 int platform_SC_set_inverse_conv(void){
-	uint32_t old_mask;
-	usart_config_t *config = &smartcard_usart_config;
 	uint64_t t, start_tick, curr_tick;
 	/* Dummy read variable */
 	uint8_t dummy_usart_read = 0;
@@ -611,27 +1163,25 @@ int platform_SC_set_inverse_conv(void){
 	dummy_usart_read = get_reg(usart_get_status_addr(smartcard_usart_config.usart), USART_SR_PE);
 
 	/* Reconfigure the usart with an ODD parity */
-	if(config->mode != SMARTCARD){
+	if(platform_SC_config_begin()){
+		goto err;
+	}
+	platform_SC_config_set_convention(1);
+	if(platform_SC_config_commit()){
 		goto err;
 	}
-	old_mask = config->set_mask;
-	/* Adapt the configuration at the USART level */
-	config->set_mask = USART_SET_PARITY;
-	config->parity = USART_CR1_PCE_EN | USART_CR1_PS_ODD;
-	usart_init(&smartcard_usart_config);
-	config->set_mask = old_mask;
 
 	/* Get the pending byte again (with 9600 ETU at 372 timeout) to send the proper
 	 * parity ACK to the card and continue to the next bytes ...
 	 */
         t = ((uint64_t)9600 * 372 * 1000) / 3500000;
-        start_tick = platform_get_microseconds_ticks();
+        start_tick = platform_SC_ticks_us();
         curr_tick = start_tick;
 	while(platform_SC_getc((uint8_t*)&dummy_usart_read, 0, 0)){
 		if((curr_tick - start_tick) > t){
 			goto err;
 		}
-		curr_tick = platform_get_microseconds_ticks();
+		curr_tick = platform_SC_ticks_us();
 	}
 
 	return 0;
@@ -656,6 +1206,207 @@ void platform_SC_flush(void){
 	toggle_smartcard_led();
 }
 
+/* Clock stop handling (ISO7816-3 clock stop indicator X of the first TA for T=15).
+ * The clock can only be stopped 1860 clock cycles after the last character, and
+ * the first character can only be sent 700 clock cycles after its restart.
+ */
+#define SC_CLOCK_STOP_DELAY_CYCLES      1860
+#define SC_CLOCK_RESTART_DELAY_CYCLES   700
+/* Conservative frequency for the delays when our frequency is not known yet */
+#define SC_CLOCK_STOP_MIN_FREQUENCY     1000000
+
+static volatile drv7816_clock_stop_t platform_SC_clock_stop_mode = DRV7816_CLOCK_STOP_UNSUPPORTED;
+
+/* Busy wait for a number of smartcard CLK cycles */
+static void platform_SC_wait_clock_cycles(uint32_t cycles){
+	uint64_t start_tick, curr_tick;
+	uint64_t t;
+	uint32_t frequency = platform_SC_frequency;
+
+	if(frequency == 0){
+		frequency = SC_CLOCK_STOP_MIN_FREQUENCY;
+	}
+	t = (((uint64_t)cycles * 1000000) + frequency - 1) / frequency;
+	start_tick = platform_SC_ticks_us();
+	do {
+		curr_tick = platform_SC_ticks_us();
+	} while((curr_tick - start_tick) < t);
+	return;
+}
+
+/* Set the clock stop indicator from the first TA for T=15 in the ATR (or
+ * 0 if absent, i.e. clock stop not supported).
+ */
+void platform_SC_set_clock_stop_indicator(uint8_t ta_t15){
+	/* The clock stop indicator X is in b8-b7 */
+	platform_SC_clock_stop_mode = (drv7816_clock_stop_t)((ta_t15 >> 6) & 0x3);
+	return;
+}
+
+int platform_SC_clock_stop(void){
+	if(platform_SC_clock_stopped){
+		return 0;
+	}
+	/* NB: our USART can only stop the clock in the low state */
+	if((platform_SC_clock_stop_mode != DRV7816_CLOCK_STOP_LOW) &&
+	   (platform_SC_clock_stop_mode != DRV7816_CLOCK_STOP_ANY)){
+		goto err;
+	}
+	if(platform_SC_pending_send_byte != 0){
+		/* We are still sending */
+		goto err;
+	}
+	/* Wait for the stop delay (counted from now, i.e. at least from the last character) */
+	platform_SC_wait_clock_cycles(SC_CLOCK_STOP_DELAY_CYCLES);
+	if(platform_SC_config_begin()){
+		goto err;
+	}
+	platform_SC_config_set_clock_output(false);
+	if(platform_SC_config_commit()){
+		goto err;
+	}
+	platform_SC_clock_stop_tick = platform_SC_ticks_us();
+	platform_SC_clock_stopped = true;
+
+	return 0;
+err:
+	return -1;
+}
+
+int platform_SC_clock_resume(void){
+	if(!platform_SC_clock_stopped){
+		return 0;
+	}
+	/* NB: this refuses to run while the upper layer has an open transaction */
+	if(platform_SC_config_begin()){
+		goto err;
+	}
+	platform_SC_config_set_clock_output(true);
+	if(platform_SC_config_commit()){
+		goto err;
+	}
+	platform_SC_clock_stopped_us += platform_SC_ticks_us() - platform_SC_clock_stop_tick;
+	platform_SC_clock_stopped = false;
+	/* The card needs some clock cycles before receiving our next character */
+	platform_SC_wait_clock_cycles(SC_CLOCK_RESTART_DELAY_CYCLES);
+
+	return 0;
+err:
+	return -1;
+}
+
+/* Total time (in microseconds) spent with the clock stopped */
+uint64_t platform_SC_get_clock_stopped_time(void){
+	if(platform_SC_clock_stopped){
+		return platform_SC_clock_stopped_us + (platform_SC_ticks_us() - platform_SC_clock_stop_tick);
+	}
+	return platform_SC_clock_stopped_us;
+}
+
+#if CONFIG_USR_DRV_DRVISO7816_ADAPTIVE_SPEED
+/* Adaptive speed fallback: the overrun, noise, receive parity and retransmit errors
+ * are monitored over a sliding window of transferred bytes. When too many errors happen, we step
+ * down to the next slower frequency of our clock plan (i.e. the next even divisor
+ * of the USART bus clock), and we probe back up after enough clean windows, never
+ * going above the negotiated frequency.
+ * NB: only the clock frequency changes, the ETU (i.e. the Fi/Di negotiated with the
+ * card) is kept so that the card and the USART stay in sync. This stretches the ETU
+ * duration: the waiting times held in microseconds by the upper layer must be scaled
+ * by the frequency change (see platform_SC_get_frequency).
+ */
+#define SC_SPEED_WINDOW_BYTES       128
+#define SC_SPEED_MAX_ERRORS         4
+#define SC_SPEED_PROBE_WINDOWS      8
+/* ISO7816-3 minimum clock frequency */
+#define SC_SPEED_MIN_FREQUENCY      1000000
+
+/* Errors accounted by the sliding window, on both the receive and send paths */
+#define SC_SPEED_ERRORS() (platform_SC_stats.rx_overruns + platform_SC_stats.rx_noise_errors + \
+                           platform_SC_stats.rx_parity_errors + platform_SC_stats.tx_retransmits)
+
+static uint32_t platform_SC_speed_window_bytes = 0;
+static uint32_t platform_SC_speed_window_errors = 0;
+static uint32_t platform_SC_speed_clean_windows = 0;
+
+static int platform_SC_speed_step(bool down){
+	uint32_t usart_bus_clk, prescaler, frequency, etu;
+
+	if((platform_SC_frequency == 0) || (platform_SC_etu == 0)){
+		goto err;
+	}
+	usart_bus_clk = usart_get_bus_clock(&smartcard_usart_config);
+	prescaler = usart_bus_clk / platform_SC_frequency;
+	if(down){
+		prescaler += 2;
+	}
+	else{
+		if(prescaler <= 2){
+			goto err;
+		}
+		prescaler -= 2;
+	}
+	frequency = usart_bus_clk / prescaler;
+	if((frequency < SC_SPEED_MIN_FREQUENCY) || (frequency > platform_SC_max_frequency)){
+		goto err;
+	}
+	etu = platform_SC_etu;
+	if(platform_SC_config_begin()){
+		/* Do not step while the upper layer has an open transaction */
+		goto err;
+	}
+	if(platform_SC_config_set_clocks(&etu, &frequency, platform_SC_guard_time)){
+		platform_SC_config_abort();
+		goto err;
+	}
+	if(platform_SC_config_commit()){
+		goto err;
+	}
+	log_printf("Adaptive speed: switching to %d Hz\n", frequency);
+
+	return 0;
+err:
+	return -1;
+}
+
+/* Called before sending a byte, i.e. when the card is listening */
+static void platform_SC_speed_monitor(void){
+	uint32_t bytes, errors;
+
+	bytes = (platform_SC_stats.rx_bytes + platform_SC_stats.tx_bytes) - platform_SC_speed_window_bytes;
+	errors = SC_SPEED_ERRORS() - platform_SC_speed_window_errors;
+	if(errors >= SC_SPEED_MAX_ERRORS){
+		/* Too many errors, step down without waiting for the end of the window */
+		if(platform_SC_speed_step(true) == 0){
+			platform_SC_stats.speed_step_downs++;
+		}
+		platform_SC_speed_clean_windows = 0;
+	}
+	else if(bytes >= SC_SPEED_WINDOW_BYTES){
+		if(errors == 0){
+			platform_SC_speed_clean_windows++;
+		}
+		else{
+			platform_SC_speed_clean_windows = 0;
+		}
+		if((platform_SC_speed_clean_windows >= SC_SPEED_PROBE_WINDOWS) && (platform_SC_frequency < platform_SC_max_frequency)){
+			/* Things look good, probe back up */
+			if(platform_SC_speed_step(false) == 0){
+				platform_SC_stats.speed_step_ups++;
+			}
+			platform_SC_speed_clean_windows = 0;
+		}
+	}
+	else{
+		/* The window is not over yet */
+		return;
+	}
+	/* Start a new window */
+	platform_SC_speed_window_bytes = platform_SC_stats.rx_bytes + platform_SC_stats.tx_bytes;
+	platform_SC_speed_window_errors = SC_SPEED_ERRORS();
+	return;
+}
+#endif
+
 /* Low level char PUSH/POP functions */
 /* Smartcard putc and getc handling errors:
  * The getc function is non blocking */
@@ -668,6 +1419,12 @@ int platform_SC_getc(uint8_t *c,
 	if(c == NULL){
 		goto invalid_input;
 	}
+	/* No byte can arrive while the clock is stopped: do not end the power saving
+	 * for a mere poll (the clock is resumed on the next send or reset)
+	 */
+	if(platform_SC_clock_stopped){
+		goto invalid_input;
+	}
 	if(platform_SC_pending_receive_byte != 1) {
 		goto invalid_input;
 	}
@@ -715,13 +1472,24 @@ int platform_SC_putc(uint8_t c,
 		return 0;
 	}
 	if((platform_SC_pending_send_byte == 0) || (platform_SC_pending_send_byte >= 3)){
+		/* Transparently restart a stopped clock */
+		if(platform_SC_clock_stopped && platform_SC_clock_resume()){
+			return -1;
+		}
+#if CONFIG_USR_DRV_DRVISO7816_ADAPTIVE_SPEED
+		if(platform_SC_pending_send_byte == 0){
+			platform_SC_speed_monitor();
+		}
+#endif
 		platform_SC_pending_send_byte = 1;
+		platform_SC_sent_since_reset = true;
+		platform_SC_stats.tx_bytes++;
 		/* Push the byte on the line */
 		(*usart_get_data_addr(SMARTCARD_USART)) = c;
 		return -1;
 	}
 	if(platform_SC_pending_send_byte == 2){
-		/* The byte has been sent */
+		/* The byte has been sent (the ISR is already back in receive mode) */
 		platform_SC_pending_send_byte = 0;
 		return 0;
 	}
@@ -736,11 +1504,14 @@ uint64_t platform_get_microseconds_ticks(void){
 	return tick;
 }
 
-
 void platform_SC_reinit_smartcard_contact(void){
 	/* Check the contact (is smartcard inserted) */
-	uint8_t value;
-	sys_cfg(CFG_GPIO_GET, (uint8_t)((('E' - 'A') << 4) + 2), (uint8_t*)&value);
+	/* The contact is high when there is no card */
+	uint8_t value = 1;
+	if(platform_SC_gpio_get((uint8_t)((('E' - 'A') << 4) + 2), (uint8_t*)&value) != SYS_E_DONE){
+		log_printf("Unable to read the smartcard contact\n");
+		value = 1;
+	}
 	platform_SC_is_smartcard_inserted = value;
 	platform_SC_is_smartcard_inserted = (~platform_SC_is_smartcard_inserted) & 0x1;
         if (platform_SC_is_smartcard_inserted) {
@@ -752,14 +1523,84 @@ void platform_SC_reinit_smartcard_contact(void){
 	return;
 }
 void platform_SC_reinit_iso7816(void){
+	platform_SC_clock_force_restart(true);
 	platform_SC_pending_receive_byte = 0;
 	platform_SC_pending_send_byte = 0;
 	platform_SC_byte = 0;
+	platform_SC_sent_since_reset = false;
 	received_SC_bytes_start = received_SC_bytes_end = 0;
 	mutex_init(&SC_mutex);
 	return;
 }
 
+/* Acknowledge the pending USART error flags (PE, FE, NF, ORE are cleared by a
+ * read of SR followed by a read of DR) and clear TC, without touching the USART
+ * configuration.
+ */
+static void platform_SC_ack_usart_flags(void){
+	/* Dummy read variable */
+	volatile uint32_t dummy_usart_read;
+
+	dummy_usart_read = *usart_get_status_addr(smartcard_usart_config.usart);
+	dummy_usart_read = *usart_get_data_addr(smartcard_usart_config.usart);
+	(void)dummy_usart_read;
+	/* SR bits are cleared by writing 0 and unaffected by writing 1: write the
+	 * mask directly rather than a read-modify-write, which would also clear an
+	 * RXNE raised in between (and lose its byte).
+	 */
+	*usart_get_status_addr(smartcard_usart_config.usart) = ~USART_SR_TC_Msk;
+	return;
+}
+
+/* Tiered recovery after a communication error: use the cheapest level that
+ * clears the error, and only fall back to the full reinit (which disables the
+ * USART and goes through the LED toggling delay) as a last resort.
+ */
+int platform_SC_recover(drv7816_recover_level_t level){
+	usart_config_t *config = &smartcard_usart_config;
+	uint32_t old_mask;
+
+	switch(level){
+		case DRV7816_RECOVER_LIGHT:
+		case DRV7816_RECOVER_RECONF:
+			break;
+		case DRV7816_RECOVER_FULL:
+			platform_smartcard_reinit();
+			platform_SC_reinit_iso7816();
+			platform_SC_flush();
+			return 0;
+		default:
+			goto err;
+	}
+
+	/* Restart the clock if it was stopped */
+	platform_SC_clock_force_restart(true);
+	/* Light tier: clear our ISR and ring buffer state, and the pending flags */
+	mutex_lock(&SC_mutex);
+	platform_SC_pending_receive_byte = platform_SC_pending_send_byte = 0;
+	platform_SC_byte = 0;
+	received_SC_bytes_start = received_SC_bytes_end = 0;
+	platform_SC_ack_usart_flags();
+	mutex_unlock(&SC_mutex);
+
+	if(level == DRV7816_RECOVER_RECONF){
+		/* Middle tier: reprogram the current baudrate, guard time and parity,
+		 * leaving the GPIOs and the other USART settings untouched.
+		 */
+		if(config->mode != SMARTCARD){
+			goto err;
+		}
+		old_mask = config->set_mask;
+		config->set_mask = USART_SET_BAUDRATE | USART_SET_GUARD_TIME_PS | USART_SET_PARITY;
+		usart_init(&smartcard_usart_config);
+		config->set_mask = old_mask;
+	}
+
+	return 0;
+err:
+	return -1;
+}
+
 int platform_smartcard_set_1ETU_guardtime(void){
         /* We are already at 1 ETU guard time, so return OK */
         return 0;
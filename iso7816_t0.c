@@ -0,0 +1,276 @@
+/***************************
+* Optional T=0 exchange engine: handles the ISO7816-3 T=0
+* procedure bytes inside the driver, so that the upper layer
+* issues one call per TPDU instead of polling each byte.
+*
+* The engine is a non-blocking state machine driven by
+* platform_SC_exchange_step(), so that the application can
+* interleave other work while the card computes. The blocking
+* platform_SC_T0_exchange() is built on top of it.
+*
+*/
+#include "libc/types.h"
+#include "libc/string.h"
+#include "libdrviso7816.h"
+#include "iso7816_timebase.h"
+
+#if CONFIG_USR_DRV_DRVISO7816_T0_ENGINE
+
+/* T=0 procedure bytes */
+#define SC_T0_NULL_BYTE     0x60
+
+/* Internal states of the exchange */
+enum {
+	SC_EXCHANGE_SEND_HEADER,
+	SC_EXCHANGE_WAIT_PROCEDURE,
+	SC_EXCHANGE_TRANSFER,
+	SC_EXCHANGE_WAIT_SW2
+};
+
+static void platform_SC_exchange_restart(drv7816_exchange_t *exchange){
+	exchange->hdr_offset = 0;
+	exchange->offset = 0;
+	exchange->len = exchange->header[4];
+	if((!exchange->outgoing) && (exchange->len == 0)){
+		/* For an incoming TPDU, P3 = 0 means 256 bytes */
+		exchange->len = 256;
+	}
+	exchange->state = SC_EXCHANGE_SEND_HEADER;
+	exchange->start_tick = platform_SC_ticks_us();
+	return;
+}
+
+/* Start an exchange with the command TPDU header CLA, INS, P1, P2, P3:
+ *   - For an outgoing exchange, data holds the P3 command bytes (it may be NULL
+ *     when P3 = 0), which are copied in the exchange object.
+ *   - For an incoming exchange, data must be NULL and the expected response
+ *     length (P3, 0 meaning 256) must not exceed resp_max.
+ * wt_us is the waiting time (in microseconds) between each character, at the
+ * current clock frequency: it is scaled if the frequency changes during the exchange.
+ */
+int platform_SC_exchange_start(drv7816_exchange_t *exchange, const uint8_t header[5], const uint8_t *data,
+                               drv7816_exchange_dir_t dir, uint32_t resp_max, uint32_t wt_us){
+	if((exchange == NULL) || (header == NULL)){
+		goto err;
+	}
+	switch(dir){
+		case DRV7816_EXCHANGE_OUT:
+			if((data == NULL) && (header[4] != 0)){
+				goto err;
+			}
+			exchange->outgoing = 1;
+			if(header[4] != 0){
+				memcpy(exchange->data, data, header[4]);
+			}
+			break;
+		case DRV7816_EXCHANGE_IN:
+			if((data != NULL) || (((header[4] == 0) ? 256 : header[4]) > resp_max)){
+				goto err;
+			}
+			exchange->outgoing = 0;
+			break;
+		default:
+			goto err;
+	}
+	memcpy(exchange->header, header, 5);
+	exchange->resp_max = resp_max;
+	exchange->wt_us = wt_us;
+	exchange->wt_frequency = platform_SC_get_frequency();
+	exchange->resent = 0;
+	exchange->data_len = 0;
+	exchange->sw1 = exchange->sw2 = 0;
+	exchange->status = DRV7816_EXCHANGE_BUSY;
+	platform_SC_exchange_restart(exchange);
+
+	return 0;
+err:
+	return -1;
+}
+
+/* The waiting time is defined in ETUs: when the clock frequency has changed since
+ * wt_us was computed (adaptive speed fallback), scale it accordingly.
+ */
+static uint64_t platform_SC_exchange_wt(const drv7816_exchange_t *exchange){
+	uint32_t frequency = platform_SC_get_frequency();
+
+	if((frequency == 0) || (exchange->wt_frequency == 0) || (frequency == exchange->wt_frequency)){
+		return exchange->wt_us;
+	}
+	return ((uint64_t)exchange->wt_us * exchange->wt_frequency) / frequency;
+}
+
+/* Handle one received procedure byte */
+static void platform_SC_exchange_procedure(drv7816_exchange_t *exchange, uint8_t procedure){
+	uint8_t ins = exchange->header[1];
+
+	if(procedure == SC_T0_NULL_BYTE){
+		/* The card asks for more time: our waiting time has already been extended */
+		return;
+	}
+	if(((procedure & 0xf0) == 0x60) || ((procedure & 0xf0) == 0x90)){
+		/* SW1, get SW2 and stop */
+		exchange->sw1 = procedure;
+		exchange->state = SC_EXCHANGE_WAIT_SW2;
+		return;
+	}
+	if((procedure == ins) || ((procedure ^ ins) == 0xff)){
+		/* ACK: transfer all the remaining bytes on INS, one on ~INS */
+		exchange->ack_end = (procedure == ins) ? exchange->len : (exchange->offset + 1);
+		if(exchange->ack_end > exchange->len){
+			/* The card asks for more than expected */
+			exchange->status = DRV7816_EXCHANGE_ERROR;
+			return;
+		}
+		exchange->state = SC_EXCHANGE_TRANSFER;
+		return;
+	}
+	/* Unexpected procedure byte */
+	exchange->status = DRV7816_EXCHANGE_ERROR;
+	return;
+}
+
+/* Make the exchange progress as far as possible without blocking, and return
+ * its status. This is to be called until the status is not DRV7816_EXCHANGE_BUSY
+ * anymore (e.g. from the application main loop).
+ */
+drv7816_exchange_status_t platform_SC_exchange_step(drv7816_exchange_t *exchange){
+	uint8_t c;
+	bool progress = true;
+
+	if(exchange == NULL){
+		return DRV7816_EXCHANGE_ERROR;
+	}
+	while((exchange->status == DRV7816_EXCHANGE_BUSY) && progress){
+		progress = false;
+		switch(exchange->state){
+			case SC_EXCHANGE_SEND_HEADER:
+				if(platform_SC_putc(exchange->header[exchange->hdr_offset], 0, 0) == 0){
+					progress = true;
+					exchange->hdr_offset++;
+					if(exchange->hdr_offset == 5){
+						exchange->state = SC_EXCHANGE_WAIT_PROCEDURE;
+					}
+				}
+				break;
+			case SC_EXCHANGE_WAIT_PROCEDURE:
+				if(platform_SC_getc(&c, 0, 0) == 0){
+					progress = true;
+					platform_SC_exchange_procedure(exchange, c);
+				}
+				break;
+			case SC_EXCHANGE_TRANSFER:
+				if(exchange->offset == exchange->ack_end){
+					progress = true;
+					exchange->state = SC_EXCHANGE_WAIT_PROCEDURE;
+					break;
+				}
+				if(exchange->outgoing){
+					if(platform_SC_putc(exchange->data[exchange->offset], 0, 0) == 0){
+						progress = true;
+						exchange->offset++;
+					}
+				}
+				else{
+					if(platform_SC_getc(&(exchange->data[exchange->offset]), 0, 0) == 0){
+						progress = true;
+						exchange->offset++;
+					}
+				}
+				break;
+			case SC_EXCHANGE_WAIT_SW2:
+				if(platform_SC_getc(&(exchange->sw2), 0, 0) == 0){
+					progress = true;
+					if((exchange->sw1 == 0x6c) && (!exchange->outgoing) && (!exchange->resent) &&
+					   (((exchange->sw2 == 0) ? 256 : exchange->sw2) <= exchange->resp_max)){
+						/* Wrong length: resend the command with the proper P3 (when the
+						 * response fits, else 6Cxx is returned to the caller)
+						 */
+						exchange->header[4] = exchange->sw2;
+						exchange->resent = 1;
+						platform_SC_exchange_restart(exchange);
+						break;
+					}
+					if(!exchange->outgoing){
+						exchange->data_len = exchange->offset;
+					}
+					exchange->status = DRV7816_EXCHANGE_DONE;
+				}
+				break;
+			default:
+				exchange->status = DRV7816_EXCHANGE_ERROR;
+				break;
+		}
+		if(progress){
+			/* Each character restarts the waiting time */
+			exchange->start_tick = platform_SC_ticks_us();
+		}
+	}
+	if((exchange->status == DRV7816_EXCHANGE_BUSY) &&
+	   ((platform_SC_ticks_us() - exchange->start_tick) > platform_SC_exchange_wt(exchange))){
+		exchange->status = DRV7816_EXCHANGE_ERROR;
+	}
+	if(exchange->status == DRV7816_EXCHANGE_ERROR){
+		/* Reset our send state */
+		platform_SC_putc(0, 0, 1);
+	}
+
+	return exchange->status;
+}
+
+/* Exchange one T=0 TPDU with the card:
+ *   - The NULL procedure bytes (0x60) are consumed, and extend the waiting time.
+ *   - On INS, all the remaining data bytes are transferred, on ~INS only the next one.
+ *   - SW1 (0x6X or 0x9X, except 0x60) and SW2 end the exchange. A 6Cxx (wrong
+ *     length) on an incoming TPDU is handled by resending the header with P3 = xx
+ *     when xx bytes fit in data_out. Other status words (e.g. 61xx) are returned
+ *     to the caller.
+ * The direction of the TPDU is explicit: an outgoing one sends the P3 bytes of
+ * data_in (none for P3 = 0, e.g. a case 1 command), an incoming one is refused
+ * before sending anything if P3 bytes (256 for P3 = 0) do not fit in data_out_size.
+ * The waiting time wt_us (in microseconds) applies between each character.
+ */
+int platform_SC_T0_exchange(drv7816_t0_tpdu_t *tpdu, uint32_t wt_us){
+	drv7816_exchange_t exchange;
+
+	if(tpdu == NULL){
+		goto err;
+	}
+	tpdu->data_out_len = 0;
+	switch(tpdu->dir){
+		case DRV7816_EXCHANGE_OUT:
+			if(platform_SC_exchange_start(&exchange, tpdu->header, tpdu->data_in, DRV7816_EXCHANGE_OUT, 0, wt_us)){
+				goto err;
+			}
+			break;
+		case DRV7816_EXCHANGE_IN:
+			/* The response must fit in the caller buffer: checked before sending anything */
+			if((tpdu->data_out == NULL) ||
+			   platform_SC_exchange_start(&exchange, tpdu->header, NULL, DRV7816_EXCHANGE_IN, tpdu->data_out_size, wt_us)){
+				goto err;
+			}
+			break;
+		default:
+			goto err;
+	}
+	while(platform_SC_exchange_step(&exchange) == DRV7816_EXCHANGE_BUSY){
+		continue;
+	}
+	if(exchange.status != DRV7816_EXCHANGE_DONE){
+		goto err;
+	}
+	if(tpdu->dir == DRV7816_EXCHANGE_IN){
+		if(exchange.data_len > tpdu->data_out_size){
+			goto err;
+		}
+		memcpy(tpdu->data_out, exchange.data, exchange.data_len);
+		tpdu->data_out_len = exchange.data_len;
+	}
+	tpdu->sw1 = exchange.sw1;
+	tpdu->sw2 = exchange.sw2;
+
+	return 0;
+err:
+	return -1;
+}
+
+#endif
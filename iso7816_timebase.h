@@ -0,0 +1,16 @@
+#ifndef ISO7816_TIMEBASE_H_
+#define ISO7816_TIMEBASE_H_
+
+#include "autoconf.h"
+#include "libdrviso7816.h"
+
+/* Time source of the driver polling loops (timeouts, delays): the syscall-free
+ * timer based timebase when selected, the systick syscall otherwise.
+ */
+#if CONFIG_USR_DRV_DRVISO7816_TIM_TIMEBASE
+#define platform_SC_ticks_us() platform_get_fast_microseconds_ticks()
+#else
+#define platform_SC_ticks_us() platform_get_microseconds_ticks()
+#endif
+
+#endif /* ISO7816_TIMEBASE_H_ */
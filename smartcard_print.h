@@ -4,13 +4,52 @@
 #include "autoconf.h"
 #include "libc/stdio.h"
 #include "libc/nostd.h"
+#include "libc/types.h"
 
 #define SMARTCARD_DEBUG CONFIG_SMARTCARD_DEBUG
 #define MEASURE_TOKEN_PERF
 
 /* Primitive for debug output */
 #if SMARTCARD_DEBUG
+# if CONFIG_USR_DRV_DRVISO7816_DEFERRED_LOG && defined(DRVISO7816_INTERNAL)
+/* Deferred logging (driver sources only, the upper layer including our API keeps
+ * its direct printf): the call site only pushes the format address (used as the
+ * format ID) and up to four raw 32-bit arguments in a lock-free ring, and the
+ * formatting is performed later by smartcard_log_drain() (or by a host-side
+ * decoder reading the ring). Missing arguments are padded with 0.
+ * More than four arguments, or an argument wider than 32 bits (e.g. uint64_t or
+ * double), is refused at compile time. The format is still checked against the
+ * arguments through a dead printf call.
+ * NB: since the formatting is deferred, the %s arguments must point to static
+ * (constant) strings.
+ */
+void smartcard_log_push(const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+/* Number of arguments, format included (up to 16) */
+#define SMARTCARD_LOG_NARGS(...) \
+        SMARTCARD_LOG_NARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define SMARTCARD_LOG_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+/* Arrays (e.g. string literals) decay to pointers (32 bits on our target), small
+ * integers are promoted
+ */
+#define SMARTCARD_LOG_ARG(a) \
+        (__extension__({ _Static_assert((__builtin_classify_type((a) + 0) == 5 /* pointer */) || \
+                                        (sizeof((a) + 0) <= sizeof(uint32_t)), \
+                                        "log_printf: argument wider than 32 bits in deferred mode"); \
+                         (uint32_t)(physaddr_t)(a); }))
+#define SMARTCARD_LOG_PUSH(fmt, a0, a1, a2, a3, ...) \
+        smartcard_log_push((fmt), SMARTCARD_LOG_ARG(a0), SMARTCARD_LOG_ARG(a1), \
+                           SMARTCARD_LOG_ARG(a2), SMARTCARD_LOG_ARG(a3))
+#define log_printf(...) do { \
+        _Static_assert(SMARTCARD_LOG_NARGS(__VA_ARGS__) <= 5, \
+                       "log_printf: more than 4 arguments in deferred mode"); \
+        if (0) { \
+            printf(__VA_ARGS__); \
+        } \
+        SMARTCARD_LOG_PUSH(__VA_ARGS__, 0, 0, 0, 0, 0); \
+} while (0)
+# else
 #define log_printf(...) printf(__VA_ARGS__)
+# endif
 #else
 #define log_printf(...)
 #endif
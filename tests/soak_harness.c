@@ -0,0 +1,374 @@
+/*
+ * Host-side soak harness of the ISO7816 low level driver.
+ *
+ * The driver sources are compiled on the host against the stubs of the
+ * tests/stubs directory. The USART interrupt is modeled by a periodic POSIX
+ * timer signal: exactly like the USART ISR on the target, the signal handler
+ * (calling platform_smartcard_irq) asynchronously preempts the main thread
+ * (calling platform_SC_getc) at any point, including inside the reception
+ * ring buffer critical section. This does not need more than one host core.
+ *
+ * For each consumer delay (i.e. the time spent by the upper layer handling
+ * each received byte), the simulated card byte rate is doubled until bytes
+ * are lost. The highest loss-free rate is then compared to the committed
+ * thresholds file, and the harness fails when it is lower (regression).
+ */
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+
+/* Fake USART registers */
+static volatile uint32_t soak_usart_sr = 0;
+static volatile uint32_t soak_usart_dr = 0;
+
+/* We need the static ISR of the driver: include the driver itself */
+#include "../iso7816_platform.c"
+
+const stub_dev_infos_t smartcard_dev_infos = {
+    .gpios = { { 4, 2 }, { 4, 3 }, { 3, 7 }, { 0, 0 } }
+};
+const stub_dev_infos_t led0_dev_infos = {
+    .gpios = { { 3, 14 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }
+};
+const stub_dev_infos_t dfu_button_dev_infos = {
+    .gpios = { { 4, 15 }, { 0, 0 }, { 0, 0 }, { 0, 0 } }
+};
+
+/* libusart stubs */
+uint8_t usart_early_init(usart_config_t *config __attribute__((unused)),
+                         usart_map_mode_t map_mode __attribute__((unused)))
+{
+    return 0;
+}
+
+void usart_init(usart_config_t *config __attribute__((unused)))
+{
+    return;
+}
+
+void usart_enable(usart_config_t *config __attribute__((unused)))
+{
+    return;
+}
+
+void usart_disable(usart_config_t *config __attribute__((unused)))
+{
+    return;
+}
+
+uint32_t usart_get_bus_clock(usart_config_t *config __attribute__((unused)))
+{
+    return 42000000;
+}
+
+volatile uint32_t *usart_get_data_addr(uint8_t usart __attribute__((unused)))
+{
+    return &soak_usart_dr;
+}
+
+volatile uint32_t *usart_get_status_addr(uint8_t usart __attribute__((unused)))
+{
+    return &soak_usart_sr;
+}
+
+int usart_map(void)
+{
+    return 0;
+}
+
+int usart_unmap(void)
+{
+    return 0;
+}
+
+/* Number of card bytes of each soak run */
+#define SOAK_BURST_BYTES        1024
+/* Each (rate, delay) point is tried this many times before failing it, to
+ * absorb the host scheduling noise
+ */
+#define SOAK_ATTEMPTS           5
+#define SOAK_MIN_RATE           500
+#define SOAK_MAX_RATE           128000
+#define SOAK_MAX_DELAYS         16
+
+static timer_t soak_timer;
+static volatile uint32_t soak_sent = 0;
+static volatile uint32_t soak_target = 0;
+/* Sequence numbers of the bytes actually stored by the ISR, in order */
+static uint32_t soak_stored[SOAK_BURST_BYTES];
+static volatile uint32_t soak_num_stored = 0;
+
+/* The "USART interrupt": one RXNE per timer expiry. The expiries coalesced
+ * by the host (timer overruns) are delivered as a burst of ISRs.
+ */
+static void soak_irq_handler(int sig __attribute__((unused)))
+{
+    int overrun = timer_getoverrun(soak_timer);
+    int i;
+
+    if (overrun < 0) {
+        overrun = 0;
+    }
+    uint32_t rx_bytes;
+
+    for (i = 0; i <= overrun; i++) {
+        if (soak_sent >= soak_target) {
+            return;
+        }
+        rx_bytes = platform_SC_stats.rx_bytes;
+        platform_smartcard_irq(USART_SR_RXNE_Msk, soak_sent & 0xff);
+        if (platform_SC_stats.rx_bytes != rx_bytes) {
+            soak_stored[soak_num_stored++] = soak_sent;
+        }
+        soak_sent++;
+    }
+}
+
+static uint64_t soak_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static void soak_busy_wait_us(uint32_t us)
+{
+    uint64_t end = soak_now_ns() + ((uint64_t)us * 1000);
+
+    while (soak_now_ns() < end) {
+        continue;
+    }
+}
+
+static int soak_arm_timer(uint32_t rate)
+{
+    struct itimerspec its;
+    uint64_t period_ns = 1000000000ULL / rate;
+
+    its.it_interval.tv_sec = period_ns / 1000000000ULL;
+    its.it_interval.tv_nsec = period_ns % 1000000000ULL;
+    its.it_value = its.it_interval;
+    return timer_settime(soak_timer, 0, &its, NULL);
+}
+
+static void soak_disarm_timer(void)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    timer_settime(soak_timer, 0, &its, NULL);
+}
+
+/* One soak run: returns the number of lost bytes (or -1 on a corrupted stream) */
+static int soak_run(uint32_t rate, uint32_t delay_us, drv7816_stats_t *stats)
+{
+    uint32_t received = 0;
+    uint8_t c;
+    bool corrupted = false;
+    bool done = false;
+
+    platform_SC_recover(DRV7816_RECOVER_LIGHT);
+    platform_SC_reset_stats();
+    soak_sent = 0;
+    soak_num_stored = 0;
+    soak_target = SOAK_BURST_BYTES;
+
+    if (soak_arm_timer(rate)) {
+        perror("timer_settime");
+        exit(2);
+    }
+    while (1) {
+        if (platform_SC_getc(&c, 0, 0) == 0) {
+            /* Bytes may be dropped by the ISR (and accounted), but the
+             * stored ones must come out in order and unaltered
+             */
+            if ((received >= soak_num_stored) ||
+                (c != (soak_stored[received] & 0xff))) {
+                corrupted = true;
+            }
+            received++;
+            soak_busy_wait_us(delay_us);
+        } else if (done) {
+            /* The producer was done before our ring buffer got empty */
+            break;
+        } else {
+            done = (soak_sent >= soak_target);
+        }
+    }
+    soak_disarm_timer();
+    platform_SC_get_stats(stats);
+
+    if (corrupted || (stats->rx_bytes != received) ||
+        ((received + stats->rx_lock_drops + stats->rx_full_drops) != SOAK_BURST_BYTES)) {
+        return -1;
+    }
+    return (int)(SOAK_BURST_BYTES - received);
+}
+
+/* Highest loss-free rate, doubling the rate from SOAK_MIN_RATE */
+static uint32_t soak_sweep(uint32_t delay_us, bool *corrupted)
+{
+    drv7816_stats_t stats;
+    uint32_t rate, best = 0;
+    int attempt, lost;
+
+    for (rate = SOAK_MIN_RATE; rate <= SOAK_MAX_RATE; rate *= 2) {
+        for (attempt = 0; attempt < SOAK_ATTEMPTS; attempt++) {
+            lost = soak_run(rate, delay_us, &stats);
+            if (lost < 0) {
+                *corrupted = true;
+                return best;
+            }
+            if (lost == 0) {
+                break;
+            }
+        }
+        printf("  delay %4u us, rate %6u B/s: lost %4d (lock %u, full %u, high water %u)\n",
+               delay_us, rate, lost, stats.rx_lock_drops, stats.rx_full_drops,
+               stats.rx_ring_high_water);
+        if (lost != 0) {
+            break;
+        }
+        best = rate;
+    }
+    return best;
+}
+
+/* The card answer right after our last byte (TC) must be kept, while our echo
+ * and the erroneous card bytes must be dropped without programming a resend.
+ */
+static int soak_check_turnaround(void)
+{
+    drv7816_stats_t stats;
+    uint8_t c = 0;
+
+    platform_SC_recover(DRV7816_RECOVER_LIGHT);
+    platform_SC_reset_stats();
+    if (platform_SC_putc(0xa5, 0, 0) != -1) {
+        goto err;
+    }
+    /* Our echo, then the end of our transmission */
+    platform_smartcard_irq(USART_SR_RXNE_Msk, 0xa5);
+    platform_smartcard_irq(USART_SR_TC_Msk, 0);
+    /* The card answers with an erroneous byte, then repeats it */
+    platform_smartcard_irq(USART_SR_RXNE_Msk | USART_SR_PE_Msk, 0x61);
+    if (platform_SC_pending_send_byte != 2) {
+        goto err;
+    }
+    platform_smartcard_irq(USART_SR_RXNE_Msk, 0x60);
+    if (platform_SC_putc(0xa5, 0, 0) != 0) {
+        goto err;
+    }
+    if ((platform_SC_getc(&c, 0, 0) != 0) || (c != 0x60)) {
+        goto err;
+    }
+    /* Same once the upper layer has acknowledged the send (idle state) */
+    platform_smartcard_irq(USART_SR_RXNE_Msk | USART_SR_PE_Msk, 0x91);
+    platform_smartcard_irq(USART_SR_RXNE_Msk, 0x90);
+    if ((platform_SC_getc(&c, 0, 0) != 0) || (c != 0x90) || (platform_SC_getc(&c, 0, 0) == 0)) {
+        goto err;
+    }
+    platform_SC_get_stats(&stats);
+    if ((stats.rx_echo_drops != 1) || (stats.tx_retransmits != 0) || (stats.rx_bytes != 2) ||
+        (stats.rx_parity_errors != 2)) {
+        goto err;
+    }
+    /* Before any byte is sent after a reset, an erroneous TS is kept */
+    platform_set_smartcard_rst(0);
+    platform_set_smartcard_rst(1);
+    platform_smartcard_irq(USART_SR_RXNE_Msk | USART_SR_PE_Msk, 0x03);
+    if ((platform_SC_getc(&c, 0, 0) != 0) || (c != 0x03)) {
+        goto err;
+    }
+    platform_SC_get_stats(&stats);
+    if (stats.rx_parity_errors != 2) {
+        goto err;
+    }
+    return 0;
+err:
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    struct sigevent sev;
+    struct sigaction sa;
+    FILE *thresholds;
+    uint32_t delays[SOAK_MAX_DELAYS], mins[SOAK_MAX_DELAYS], best;
+    unsigned int num = 0, i;
+    bool corrupted = false;
+    int ret = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <thresholds file>\n", argv[0]);
+        return 2;
+    }
+    thresholds = fopen(argv[1], "r");
+    if (thresholds == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+    /* Format: one "<consumer delay in us> <minimum loss-free rate in B/s>"
+     * per line, '#' starting a comment line
+     */
+    while (num < SOAK_MAX_DELAYS) {
+        char line[128];
+
+        if (fgets(line, sizeof(line), thresholds) == NULL) {
+            break;
+        }
+        if ((line[0] == '#') || (line[0] == '\n')) {
+            continue;
+        }
+        if (sscanf(line, "%u %u", &delays[num], &mins[num]) != 2) {
+            fprintf(stderr, "%s: malformed line '%s'\n", argv[1], line);
+            return 2;
+        }
+        num++;
+    }
+    fclose(thresholds);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = soak_irq_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGRTMIN, &sa, NULL);
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGRTMIN;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &soak_timer)) {
+        perror("timer_create");
+        return 2;
+    }
+
+    platform_smartcard_init();
+    platform_SC_reinit_iso7816();
+
+    if (soak_check_turnaround()) {
+        printf("FAIL: card byte following our transmission lost or mishandled\n");
+        ret = 1;
+    }
+
+    for (i = 0; i < num; i++) {
+        corrupted = false;
+        best = soak_sweep(delays[i], &corrupted);
+        if (corrupted) {
+            printf("FAIL: delay %u us: corrupted reception stream\n", delays[i]);
+            ret = 1;
+            continue;
+        }
+        printf("%s: delay %4u us: max loss-free rate %6u B/s (threshold %6u B/s)\n",
+               (best >= mins[i]) ? "PASS" : "FAIL", delays[i], best, mins[i]);
+        if (best < mins[i]) {
+            ret = 1;
+        }
+    }
+
+    timer_delete(soak_timer);
+    return ret;
+}
@@ -0,0 +1,8 @@
+/* Host stub: driver configuration for the soak harness */
+#ifndef __AUTOCONF_H__
+#define __AUTOCONF_H__
+
+#define CONFIG_WOOKEY 0
+#define CONFIG_SMARTCARD_DEBUG 0
+
+#endif
@@ -0,0 +1,11 @@
+/* Host stub of the generated DFU button device information */
+#ifndef __GENERATED_DFU_BUTTON_H__
+#define __GENERATED_DFU_BUTTON_H__
+
+#include "generated/smartcard.h"
+
+#define DFU_BTN 0
+
+extern const stub_dev_infos_t dfu_button_dev_infos;
+
+#endif
@@ -0,0 +1,11 @@
+/* Host stub of the generated LED device information */
+#ifndef __GENERATED_LED0_H__
+#define __GENERATED_LED0_H__
+
+#include "generated/smartcard.h"
+
+#define LED0 0
+
+extern const stub_dev_infos_t led0_dev_infos;
+
+#endif
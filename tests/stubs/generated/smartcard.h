@@ -0,0 +1,18 @@
+/* Host stub of the generated smartcard device information */
+#ifndef __GENERATED_SMARTCARD_H__
+#define __GENERATED_SMARTCARD_H__
+
+#include "libc/types.h"
+
+enum { SMARTCARD_CON, SMARTCARD_RST, SMARTCARD_VCC };
+
+typedef struct {
+    struct {
+        uint8_t port;
+        uint8_t pin;
+    } gpios[4];
+} stub_dev_infos_t;
+
+extern const stub_dev_infos_t smartcard_dev_infos;
+
+#endif
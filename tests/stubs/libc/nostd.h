@@ -0,0 +1,5 @@
+/* Host stub of the EwoK libc non-standard functions */
+#ifndef __LIBC_NOSTD_H__
+#define __LIBC_NOSTD_H__
+
+#endif
@@ -0,0 +1,19 @@
+/* Host stub of the EwoK libc register helpers */
+#ifndef __LIBC_REGUTILS_H__
+#define __LIBC_REGUTILS_H__
+
+#include "libc/types.h"
+
+#define get_reg(r, field) ((*(r) & field##_Msk) >> field##_Pos)
+
+static inline void set_reg_bits(volatile uint32_t *reg, uint32_t value)
+{
+    *reg |= value;
+}
+
+static inline void clear_reg_bits(volatile uint32_t *reg, uint32_t value)
+{
+    *reg &= ~value;
+}
+
+#endif
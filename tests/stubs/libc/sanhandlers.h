@@ -0,0 +1,14 @@
+/* Host stub of the EwoK libc handlers sanitization */
+#ifndef __LIBC_SANHANDLERS_H__
+#define __LIBC_SANHANDLERS_H__
+
+#include "libc/types.h"
+
+#define ADD_GLOB_HANDLER(handler)
+
+static inline int handler_sanity_check_with_panic(physaddr_t handler __attribute__((unused)))
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,34 @@
+/* Host stub of the EwoK libc mutexes: like on the target, mutex_trylock
+ * never blocks (it is called from the ISR) and mutex_lock spins.
+ */
+#ifndef __LIBC_SEMAPHORE_H__
+#define __LIBC_SEMAPHORE_H__
+
+#include "libc/types.h"
+
+static inline void mutex_init(uint32_t *mutex)
+{
+    __atomic_store_n(mutex, 1, __ATOMIC_RELEASE);
+}
+
+static inline bool mutex_trylock(uint32_t *mutex)
+{
+    uint32_t expected = 1;
+
+    return __atomic_compare_exchange_n(mutex, &expected, 0, false,
+                                       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static inline void mutex_lock(uint32_t *mutex)
+{
+    while (!mutex_trylock(mutex)) {
+        continue;
+    }
+}
+
+static inline void mutex_unlock(uint32_t *mutex)
+{
+    __atomic_store_n(mutex, 1, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,7 @@
+/* Host stub of the EwoK libc stdio */
+#ifndef __LIBC_STDIO_H__
+#define __LIBC_STDIO_H__
+
+#include <stdio.h>
+
+#endif
@@ -0,0 +1,7 @@
+/* Host stub of the EwoK libc string functions */
+#ifndef __LIBC_STRING_H__
+#define __LIBC_STRING_H__
+
+#include <string.h>
+
+#endif
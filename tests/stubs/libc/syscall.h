@@ -0,0 +1,97 @@
+/* Host stub of the EwoK syscalls used by the driver */
+#ifndef __LIBC_SYSCALL_H__
+#define __LIBC_SYSCALL_H__
+
+#include <time.h>
+#include "libc/types.h"
+
+typedef enum {
+    SYS_E_DONE = 0,
+    SYS_E_INVAL,
+    SYS_E_DENIED,
+    SYS_E_BUSY
+} e_syscall_ret;
+
+typedef enum {
+    PREC_MILLI,
+    PREC_MICRO,
+    PREC_CYCLE
+} e_tick_type;
+
+enum { CFG_GPIO_SET, CFG_GPIO_GET };
+enum { INIT_DEVACCESS, INIT_DONE };
+
+typedef struct {
+    uint8_t port;
+    uint8_t pin;
+} kref_t;
+
+typedef struct {
+    uint32_t mask;
+    kref_t   kref;
+    uint32_t mode;
+    uint32_t pupd;
+    uint32_t type;
+    uint32_t speed;
+    uint32_t exti_trigger;
+    void   (*exti_handler)(uint8_t, uint32_t, uint32_t);
+} dev_gpio_info_t;
+
+typedef enum { DEV_MAP_AUTO, DEV_MAP_VOLUNTARY } dev_map_mode_t;
+
+typedef struct {
+    char            name[16];
+    physaddr_t      address;
+    uint32_t        size;
+    uint8_t         irq_num;
+    uint8_t         gpio_num;
+    dev_map_mode_t  map_mode;
+    dev_gpio_info_t gpios[16];
+} device_t;
+
+#define GPIO_MASK_SET_EXTI          (1 << 0)
+#define GPIO_MASK_SET_MODE          (1 << 1)
+#define GPIO_MASK_SET_PUPD          (1 << 2)
+#define GPIO_MASK_SET_TYPE          (1 << 3)
+#define GPIO_MASK_SET_SPEED         (1 << 4)
+#define GPIO_PIN_INPUT_MODE         0
+#define GPIO_PIN_OUTPUT_MODE        1
+#define GPIO_NOPULL                 0
+#define GPIO_PULLDOWN               2
+#define GPIO_PIN_OTYPER_PP          0
+#define GPIO_PIN_OTYPER_OD          1
+#define GPIO_PIN_LOW_SPEED          0
+#define GPIO_PIN_HIGH_SPEED         2
+#define GPIO_PIN_VERY_HIGH_SPEED    3
+#define GPIO_EXTI_TRIGGER_BOTH      3
+
+static inline e_syscall_ret sys_cfg(uint32_t type __attribute__((unused)), ...)
+{
+    return SYS_E_DONE;
+}
+
+static inline e_syscall_ret sys_init(uint32_t type __attribute__((unused)), ...)
+{
+    return SYS_E_DONE;
+}
+
+static inline e_syscall_ret sys_get_systick(uint64_t *val, e_tick_type prec)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    switch (prec) {
+        case PREC_MILLI:
+            *val = ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+            break;
+        case PREC_MICRO:
+            *val = ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+            break;
+        default:
+            *val = ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+            break;
+    }
+    return SYS_E_DONE;
+}
+
+#endif
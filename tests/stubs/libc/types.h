@@ -0,0 +1,11 @@
+/* Host stub of the EwoK libc types */
+#ifndef __LIBC_TYPES_H__
+#define __LIBC_TYPES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uintptr_t physaddr_t;
+
+#endif
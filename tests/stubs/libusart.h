@@ -0,0 +1,76 @@
+/* Host stub of the libusart API (implemented by the soak harness) */
+#ifndef __LIBUSART_H__
+#define __LIBUSART_H__
+
+#include "libc/types.h"
+#include "libusart_fields.h"
+
+typedef enum { UART, USART, SMARTCARD } usart_mode_t;
+typedef enum { USART_MAP_AUTO, USART_MAP_VOLUNTARY } usart_map_mode_t;
+
+typedef uint8_t (*cb_usart_getc_t)(void);
+typedef void (*cb_usart_putc_t)(uint8_t);
+typedef void (*cb_usart_irq_handler_t)(uint32_t, uint32_t);
+
+#define USART_SET_BAUDRATE          (1 << 0)
+#define USART_SET_WORD_LENGTH       (1 << 1)
+#define USART_SET_STOP_BITS         (1 << 2)
+#define USART_SET_PARITY            (1 << 3)
+#define USART_SET_HW_FLOW_CTRL      (1 << 4)
+#define USART_SET_OPTIONS_CR1       (1 << 5)
+#define USART_SET_OPTIONS_CR2       (1 << 6)
+#define USART_SET_GUARD_TIME_PS     (1 << 7)
+#define USART_SET_ALL               0xff
+
+#define USART_CR1_M_9               (1 << 12)
+#define USART_CR1_PCE_EN            (1 << 10)
+#define USART_CR1_PS_EVEN           0
+#define USART_CR1_PS_ODD            (1 << 9)
+#define USART_CR1_PEIE_EN           (1 << 8)
+#define USART_CR1_TCIE_EN           (1 << 6)
+#define USART_CR1_RXNEIE_EN         (1 << 5)
+#define USART_CR1_TE_EN             (1 << 3)
+#define USART_CR1_RE_EN             (1 << 2)
+#define USART_CR2_STOP_1BIT         0
+#define USART_CR2_STOP_1_5BITS      (3 << 12)
+#define USART_CR2_LINEN_DIS         0
+#define USART_CR2_CLKEN_PIN_EN      (1 << 11)
+#define USART_CR2_CPOL_DIS          0
+#define USART_CR2_CPHA_DIS          0
+#define USART_CR2_LBCL_EN           (1 << 8)
+#define USART_CR3_CTSE_CTS_DIS      0
+#define USART_CR3_RTSE_RTS_DIS      0
+#define USART_CR3_SCEN_EN           (1 << 5)
+#define USART_CR3_NACK_EN           (1 << 4)
+#define USART_CR3_HDSEL_DIS         0
+#define USART_CR3_IREN_DIS          0
+#define USART_CR3_EIE_EN            (1 << 0)
+
+typedef struct {
+    uint32_t                set_mask;
+    usart_mode_t            mode;
+    uint8_t                 usart;
+    uint32_t                baudrate;
+    uint32_t                word_length;
+    uint32_t                stop_bits;
+    uint32_t                parity;
+    uint32_t                hw_flow_control;
+    uint32_t                options_cr1;
+    uint32_t                options_cr2;
+    uint32_t                guard_time_prescaler;
+    cb_usart_irq_handler_t  callback_irq_handler;
+    cb_usart_getc_t        *callback_usart_getc_ptr;
+    cb_usart_putc_t        *callback_usart_putc_ptr;
+} usart_config_t;
+
+uint8_t usart_early_init(usart_config_t *config, usart_map_mode_t map_mode);
+void usart_init(usart_config_t *config);
+void usart_enable(usart_config_t *config);
+void usart_disable(usart_config_t *config);
+uint32_t usart_get_bus_clock(usart_config_t *config);
+volatile uint32_t *usart_get_data_addr(uint8_t usart);
+volatile uint32_t *usart_get_status_addr(uint8_t usart);
+int usart_map(void);
+int usart_unmap(void);
+
+#endif
@@ -0,0 +1,21 @@
+/* Host stub of the libusart register fields (STM32F4 USART_SR/GTPR) */
+#ifndef __LIBUSART_FIELDS_H__
+#define __LIBUSART_FIELDS_H__
+
+#define USART_SR_PE_Pos         0
+#define USART_SR_PE_Msk         (1 << USART_SR_PE_Pos)
+#define USART_SR_FE_Pos         1
+#define USART_SR_FE_Msk         (1 << USART_SR_FE_Pos)
+#define USART_SR_NF_Pos         2
+#define USART_SR_NF_Msk         (1 << USART_SR_NF_Pos)
+#define USART_SR_ORE_Pos        3
+#define USART_SR_ORE_Msk        (1 << USART_SR_ORE_Pos)
+#define USART_SR_RXNE_Pos       5
+#define USART_SR_RXNE_Msk       (1 << USART_SR_RXNE_Pos)
+#define USART_SR_TC_Pos         6
+#define USART_SR_TC_Msk         (1 << USART_SR_TC_Pos)
+
+#define USART_GTPR_PSC_Pos      0
+#define USART_GTPR_GT_Pos       8
+
+#endif